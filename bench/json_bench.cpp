@@ -0,0 +1,100 @@
+// JSON parsing benchmark: the legacy recursive-descent JsonHandler::parse
+// versus the two-stage JsonDocument::parse, plus stage 1 (the structural
+// index) on its own.
+
+#include "httpapi/json_handler.hpp"
+#include "httpapi/json_value.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace httpapi;
+
+static std::atomic<size_t> allocationCount{0};
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+static const int kRecords = 20000;
+static const int kIterations = 20;
+
+// An API-style payload: an object wrapping an array of records that mix
+// integers, floats, short and escaped strings, booleans, nulls and nesting
+static std::string makePayload() {
+    std::string json = "{\"records\": [\n";
+    for (int i = 0; i < kRecords; ++i) {
+        if (i > 0) {
+            json += ",\n";
+        }
+        json += "  {\"id\": " + std::to_string(i * 7919) +
+                ", \"name\": \"user" + std::to_string(i) + "\"" +
+                ", \"email\": \"user" + std::to_string(i) + "@example.com\"" +
+                ", \"score\": " + std::to_string(i * 0.37) +
+                ", \"active\": " + (i % 3 ? "true" : "false") +
+                ", \"manager\": null" +
+                ", \"bio\": \"Line one\\nLine \\\"two\\\" \\u00e9\"" +
+                ", \"tags\": [\"alpha\", \"beta\", " + std::to_string(i % 100) + "]" +
+                ", \"location\": {\"lat\": -33.8688, \"lng\": 151.2093}}";
+    }
+    json += "\n]}";
+    return json;
+}
+
+template<typename Fn>
+static void report(const char* name, size_t bytes, Fn&& fn) {
+    fn();
+    
+    size_t allocationsBefore = allocationCount.load();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        fn();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    size_t allocations = allocationCount.load() - allocationsBefore;
+    
+    double seconds = std::chrono::duration<double>(elapsed).count() / kIterations;
+    std::cout << name << ": " << seconds * 1e3 << " ms/parse, "
+              << bytes / seconds / 1e6 << " MB/s, "
+              << static_cast<double>(allocations) / kIterations << " allocations/parse"
+              << std::endl;
+}
+
+int main() {
+    std::string payload = makePayload();
+    size_t sink = 0;
+    
+    std::cout << payload.size() << "-byte payload, " << kIterations << " iterations, "
+              << "structural index: " << JsonStructuralIndex::implementation() << std::endl;
+    report("JsonHandler::parse (legacy)", payload.size(), [&]() {
+        sink += JsonHandler::parse(payload).size();
+    });
+    std::vector<uint32_t> positions;
+    report("JsonStructuralIndex::build (stage 1 only)", payload.size(), [&]() {
+        JsonStructuralIndex::build(payload.data(), payload.size(), positions);
+        sink += positions.size();
+    });
+    report("JsonDocument::parse", payload.size(), [&]() {
+        JsonDocument document = JsonDocument::parse(payload);
+        sink += document["records"].size();
+    });
+    
+    return sink == 0;
+}
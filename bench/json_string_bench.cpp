@@ -0,0 +1,164 @@
+// JSON string benchmark: escaping, unescaping and UTF-8 validation with the
+// vectorized JsonString routines versus byte-at-a-time loops, on an
+// ASCII-heavy corpus (long clean runs) and an escape-heavy one.
+
+#include "httpapi/json_string.hpp"
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+using namespace httpapi;
+
+static const size_t kCorpusSize = 4 * 1024 * 1024;
+static const int kIterations = 20;
+
+// Prose with a quote or newline every few hundred bytes, and some
+// multi-byte UTF-8
+static std::string makeAsciiHeavy() {
+    static const char* const words[] = {
+        "request", "response", "header", "latency", "throughput", "server",
+        "caf\xC3\xA9", "client", "payload", "stream", "buffer", "socket"
+    };
+    std::string text;
+    size_t i = 0;
+    while (text.size() < kCorpusSize) {
+        text += words[i % 12];
+        text += (i % 37 == 0) ? "\"" : (i % 53 == 0) ? "\n" : " ";
+        ++i;
+    }
+    return text;
+}
+
+// Log lines and code snippets: quotes, backslashes, tabs and newlines in
+// nearly every short run
+static std::string makeEscapeHeavy() {
+    static const char* const pieces[] = {
+        "\"key\"", "C:\\path\\to", "\t", "line\n", "say \"hi\"", "\x01", "a\\b", "\r\n"
+    };
+    std::string text;
+    size_t i = 0;
+    while (text.size() < kCorpusSize) {
+        text += pieces[i % 8];
+        ++i;
+    }
+    return text;
+}
+
+static void escapeBytewise(const std::string& text, std::string& out) {
+    static const char hexDigits[] = "0123456789abcdef";
+    for (unsigned char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    out += "\\u00";
+                    out += hexDigits[c >> 4];
+                    out += hexDigits[c & 0xF];
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+}
+
+static void unescapeBytewise(const std::string& raw, std::string& out) {
+    for (size_t i = 0; i < raw.size(); ++i) {
+        if (raw[i] != '\\') {
+            out += raw[i];
+            continue;
+        }
+        switch (raw[++i]) {
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': out += static_cast<char>(std::stoi(raw.substr(i + 1, 4), nullptr, 16)); i += 4; break;
+            default: out += raw[i]; break;
+        }
+    }
+}
+
+static bool validateBytewise(const std::string& text) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(text.data());
+    const unsigned char* end = p + text.size();
+    while (p < end) {
+        unsigned c = *p;
+        size_t length = c < 0x80 ? 1 : (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 0;
+        if (length == 0 || static_cast<size_t>(end - p) < length) {
+            return false;
+        }
+        for (size_t i = 1; i < length; ++i) {
+            if ((p[i] & 0xC0) != 0x80) {
+                return false;
+            }
+        }
+        p += length;
+    }
+    return true;
+}
+
+template<typename Fn>
+static void report(const char* name, size_t bytes, Fn&& fn) {
+    fn();
+    
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        fn();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    
+    double seconds = std::chrono::duration<double>(elapsed).count() / kIterations;
+    std::cout << "  " << name << ": " << bytes / seconds / 1e6 << " MB/s" << std::endl;
+}
+
+// Called through a volatile pointer so the compiler cannot hoist the
+// (pure) validation out of the timing loop
+static bool (*volatile validateLoop)(const std::string&) = validateBytewise;
+static bool (*volatile validateSimd)(std::string_view) = JsonString::isValidUtf8;
+
+static size_t runCorpus(const char* label, const std::string& text) {
+    size_t sink = 0;
+    std::string escaped;
+    JsonString::escape(text, escaped);
+    std::string out;
+    
+    std::cout << label << " (" << text.size() << " bytes, " << escaped.size() << " escaped)" << std::endl;
+    report("escape, byte loop", text.size(), [&]() {
+        out.clear();
+        escapeBytewise(text, out);
+        sink += out.size();
+    });
+    report("escape, JsonString", text.size(), [&]() {
+        out.clear();
+        JsonString::escape(text, out);
+        sink += out.size();
+    });
+    report("unescape, byte loop", escaped.size(), [&]() {
+        out.clear();
+        unescapeBytewise(escaped, out);
+        sink += out.size();
+    });
+    report("unescape, JsonString", escaped.size(), [&]() {
+        out.clear();
+        JsonString::unescape(escaped, out);
+        sink += out.size();
+    });
+    report("UTF-8 validation, byte loop", text.size(), [&]() {
+        sink += validateLoop(text);
+    });
+    report("UTF-8 validation, JsonString", text.size(), [&]() {
+        sink += validateSimd(text);
+    });
+    return sink;
+}
+
+int main() {
+    std::cout << kIterations << " iterations, implementation: " << JsonString::implementation() << std::endl;
+    size_t sink = runCorpus("ASCII-heavy", makeAsciiHeavy());
+    sink += runCorpus("Escape-heavy", makeEscapeHeavy());
+    return sink == 0;
+}
@@ -1,5 +1,7 @@
 #include "httpapi/http_server.hpp"
 #include "httpapi/json_handler.hpp"
+#include "httpapi/compression.hpp"
+#include "httpapi/payload.hpp"
 #include <iostream>
 #include <thread>
 #include <chrono>
@@ -31,6 +33,9 @@ int main() {
         next();
     });
     
+    // Middleware - gzip/br compression for larger text responses
+    app.use(Compression::middleware());
+    
     // Basic routes
     app.get("/", [](Request& req, Response& res) {
         res.json("{\"message\": \"Welcome to HttpApi - Express.js-like C++ Framework!\", \"version\": \"1.0.0\"}");
@@ -47,13 +52,26 @@ int main() {
     
     // JSON API routes
     app.get("/api/users", [](Request& req, Response& res) {
-        std::vector<std::unordered_map<std::string, std::any>> users = {
-            {{"id", 1}, {"name", "John Doe"}, {"email", "john@example.com"}},
-            {{"id", 2}, {"name", "Jane Smith"}, {"email", "jane@example.com"}},
-            {{"id", 3}, {"name", "Bob Johnson"}, {"email", "bob@example.com"}}
+        static const char* const users[][2] = {
+            {"John Doe", "john@example.com"},
+            {"Jane Smith", "jane@example.com"},
+            {"Bob Johnson", "bob@example.com"}
         };
         
-        res.json(JsonHandler::stringify(users));
+        // Rows are written while the response is being sent, the way a
+        // database cursor would feed them; use res.ndjson() for one per line
+        res.jsonArray([next = size_t(0)](JsonWriter& w) mutable {
+            if (next == std::size(users)) {
+                return false;
+            }
+            w.beginObject()
+                .member("id", next + 1)
+                .member("name", users[next][0])
+                .member("email", users[next][1])
+                .endObject();
+            ++next;
+            return true;
+        });
     });
     
     app.get("/api/users/:id", [](Request& req, Response& res) {
@@ -67,15 +85,16 @@ int main() {
                 {"email", "john@example.com"},
                 {"created_at", "2024-01-01"}
             };
-            res.json(JsonHandler::stringify(user));
+            // JSON, MessagePack or CBOR depending on the Accept header
+            Payload::send(req, res, user);
         } else {
             res.status(404).json("{\"error\": \"User not found\"}");
         }
     });
     
     app.post("/api/users", [](Request& req, Response& res) {
-        // Parse JSON body
-        auto userData = JsonHandler::parse(req.body);
+        // Parse the body as JSON, MessagePack or CBOR per its Content-Type
+        auto userData = Payload::parse(req);
         
         if (userData.find("name") == userData.end() || userData.find("email") == userData.end()) {
             res.status(400).json("{\"error\": \"Name and email are required\"}");
@@ -90,7 +109,8 @@ int main() {
             {"created_at", "2024-01-01"}
         };
         
-        res.status(201).json(JsonHandler::stringify(newUser));
+        res.status(201);
+        Payload::send(req, res, newUser);
     });
     
     app.put("/api/users/:id", [](Request& req, Response& res) {
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "request.hpp"
+#include "response.hpp"
+
+namespace httpapi {
+
+struct CoalescingOptions {
+    // Key on the whole query string, or only on queryKeys when that is non-empty
+    bool includeQuery = true;
+    std::vector<std::string> queryKeys;
+    
+    // Request headers that distinguish otherwise identical requests. Requests
+    // carrying Authorization or Cookie are only coalesced when that header
+    // is listed here.
+    std::vector<std::string> keyHeaders;
+};
+
+// Collapses concurrent identical GET/HEAD requests onto one handler run
+// ("singleflight"). Opt in per route:
+//
+//     app.get("/api/report", RequestCoalescer::wrap(reportHandler));
+//
+// Requests arriving while the first is still running wait for it and receive
+// a copy of its status, headers and body; later requests start a new run.
+// A streamed response (Response::stream), or one with Set-Cookie or
+// Cache-Control private/no-store, is not shared: if the first run produces
+// one, the waiting requests run the handler themselves.
+class RequestCoalescer {
+public:
+    using RequestHandler = std::function<void(Request&, Response&)>;
+    
+    static RequestHandler wrap(RequestHandler handler, CoalescingOptions options = CoalescingOptions());
+};
+
+} // namespace httpapi 
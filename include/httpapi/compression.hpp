@@ -0,0 +1,95 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+#include "middleware.hpp"
+
+namespace httpapi {
+
+enum class ContentEncoding {
+    Identity,
+    Gzip,
+    Deflate,
+    Brotli,
+    Zstd
+};
+
+struct CompressionOptions {
+    // Bodies smaller than this are sent as-is
+    size_t threshold = 1024;
+    
+    // Compression level (zlib 1-9, brotli 0-11, zstd 1-22; -1 = encoder default)
+    int level = -1;
+    
+    // Byte budget for compressed variants of immutable bodies (0 disables)
+    size_t cacheBytes = 16 * 1024 * 1024;
+    
+    // Content-Type prefixes worth compressing
+    std::vector<std::string> types = {
+        "text/",
+        "application/json",
+        "application/x-ndjson",
+        "application/javascript",
+        "application/xml",
+        "image/svg+xml"
+    };
+};
+
+// Incremental compressor for one content encoding. Output is appended to the
+// caller's buffer, so the same object serves whole bodies and chunked streams.
+class Compressor {
+public:
+    explicit Compressor(ContentEncoding encoding, int level = -1);
+    ~Compressor();
+    
+    Compressor(const Compressor&) = delete;
+    Compressor& operator=(const Compressor&) = delete;
+    
+    // Compress input, appending whatever output the encoder produces
+    void update(const char* data, size_t size, std::string& out);
+    
+    // Emit everything buffered so far so the receiver can decode it (chunk boundary)
+    void flush(std::string& out);
+    
+    // Finish the stream and append the trailer
+    void finish(std::string& out);
+    
+    ContentEncoding encoding() const { return encoding_; }
+    
+private:
+    struct Impl;
+    
+    ContentEncoding encoding_;
+    std::unique_ptr<Impl> impl_;
+};
+
+class Compression {
+public:
+    // Whether the library was built with support for an encoding
+    static bool isAvailable(ContentEncoding encoding);
+    
+    // Pick the best available encoding for an Accept-Encoding header
+    static ContentEncoding negotiate(const std::string& acceptEncoding);
+    
+    // Pick the best of the given candidates (e.g. precompressed files on disk)
+    static ContentEncoding negotiate(const std::string& acceptEncoding,
+                                     const std::vector<ContentEncoding>& candidates);
+    
+    // Content-Encoding token ("gzip", "br", ...)
+    static std::string encodingName(ContentEncoding encoding);
+    
+    // One-shot compression
+    static std::string compress(std::string_view data, ContentEncoding encoding, int level = -1);
+    
+    // Middleware compressing eligible responses produced further down the chain
+    static Middleware::MiddlewareFunction middleware(CompressionOptions options = CompressionOptions());
+    
+    // Whether a Content-Type matches one of the configured prefixes
+    static bool isCompressible(const std::string& contentType, const std::vector<std::string>& types);
+};
+
+} // namespace httpapi 
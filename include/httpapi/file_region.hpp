@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <cstddef>
+
+namespace httpapi {
+
+// A read-only memory mapping of a whole file (mmap on POSIX, a file mapping
+// view on Windows). Regions are handed out as shared_ptr so any number of
+// in-flight responses can reference the same pages; the mapping is released
+// when the last reference goes away.
+//
+// The file should be replaced by rename rather than truncated in place while
+// mapped: reading pages past a shrunken end faults on POSIX.
+class FileRegion {
+public:
+    ~FileRegion();
+    
+    FileRegion(const FileRegion&) = delete;
+    FileRegion& operator=(const FileRegion&) = delete;
+    
+    // Returns nullptr if the file cannot be opened or mapped
+    static std::shared_ptr<const FileRegion> map(const std::string& path);
+    
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return std::string_view(data_, size_); }
+    
+private:
+    FileRegion();
+    
+    const char* data_;
+    size_t size_;
+#if defined(_WIN32)
+    void* mapping_;
+#endif
+};
+
+} // namespace httpapi 
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <unordered_map>
+
+namespace httpapi {
+
+// Watches a directory tree and reports changed paths from a background thread.
+// Uses inotify on Linux and ReadDirectoryChangesW on Windows. When the kernel
+// drops events, the callback receives the root directory itself, meaning
+// "anything below here may have changed".
+class FileWatcher {
+public:
+    using Callback = std::function<void(const std::string& path)>;
+    
+    FileWatcher();
+    ~FileWatcher();
+    
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+    
+    // Returns false if the platform has no watcher or the directory cannot be watched
+    bool start(const std::string& directory, Callback callback);
+    void stop();
+    bool isRunning() const;
+    
+    static bool isSupported();
+    
+private:
+    void run();
+    
+    std::string root_;
+    Callback callback_;
+    std::atomic<bool> running_;
+    std::atomic<bool> finished_;
+    std::thread thread_;
+    
+#if defined(_WIN32)
+    void* directoryHandle_;
+    // The watcher thread's own handle, published by that thread for
+    // CancelSynchronousIo; std::thread::native_handle() is not a HANDLE
+    // on every toolchain
+    std::atomic<void*> threadHandle_;
+#elif defined(__linux__)
+    void addWatches(const std::string& directory);
+    
+    int inotifyFd_;
+    std::unordered_map<int, std::string> watches_;
+#endif
+};
+
+} // namespace httpapi 
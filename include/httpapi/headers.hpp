@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace httpapi {
+
+// Header names the framework itself reads or writes. They are matched once,
+// case-insensitively, when a header is stored; afterwards lookups by id are
+// a single array index and the canonical spelling is never copied.
+enum class HeaderId : uint8_t {
+    Other,
+    Accept,
+    AcceptEncoding,
+    AcceptRanges,
+    Age,
+    Authorization,
+    CacheControl,
+    Connection,
+    ContentDisposition,
+    ContentEncoding,
+    ContentLength,
+    ContentRange,
+    ContentType,
+    Cookie,
+    Date,
+    ETag,
+    Expires,
+    Host,
+    IfModifiedSince,
+    IfNoneMatch,
+    IfRange,
+    LastModified,
+    Location,
+    Pragma,
+    Range,
+    Server,
+    SetCookie,
+    TransferEncoding,
+    UserAgent,
+    Vary,
+    Count
+};
+
+struct HeaderField {
+    HeaderId id = HeaderId::Other;
+    std::string customName; // only set when id is HeaderId::Other
+    std::string value;
+    
+    // Canonical spelling for well-known headers, as stored otherwise
+    std::string_view name() const;
+};
+
+// Ordered header list for requests and responses. Fields keep the order they
+// were added in and a name may repeat (Set-Cookie); all name comparisons are
+// case-insensitive and allocation-free. Fields live contiguously, in a fixed
+// array inside the object for typical messages and in a vector once there
+// are more, and the first field of each well-known name is found through a
+// per-id slot instead of a scan.
+class Headers {
+public:
+    using const_iterator = const HeaderField*;
+    
+    Headers();
+    
+    // Id for a header name in any case, HeaderId::Other when not well-known
+    static HeaderId lookup(std::string_view name);
+    static std::string_view canonicalName(HeaderId id);
+    static bool equalsIgnoreCase(std::string_view a, std::string_view b);
+    
+    // First value for a name, or nullptr
+    const std::string* find(std::string_view name) const;
+    const std::string* find(HeaderId id) const;
+    
+    // First value for a name, or an empty string
+    std::string get(std::string_view name) const;
+    std::string get(HeaderId id) const;
+    
+    bool has(std::string_view name) const { return find(name) != nullptr; }
+    bool has(HeaderId id) const { return find(id) != nullptr; }
+    
+    // Every value for a name, in order
+    std::vector<std::string_view> getAll(std::string_view name) const;
+    
+    // Replace all values for a name with one; a new name goes to the end
+    void set(std::string_view name, std::string value);
+    void set(HeaderId id, std::string value);
+    
+    // Append a value, keeping any existing ones
+    void add(std::string_view name, std::string value);
+    void add(HeaderId id, std::string value);
+    
+    // Remove every value for a name; returns how many were removed
+    size_t erase(std::string_view name);
+    size_t erase(HeaderId id);
+    
+    // Set each name in `other` to exactly its values there
+    void merge(const Headers& other);
+    
+    void clear();
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    const_iterator begin() const { return fields(); }
+    const_iterator end() const { return fields() + count_; }
+    
+private:
+    static constexpr size_t kKnownCount = static_cast<size_t>(HeaderId::Count);
+    static constexpr uint32_t kNoField = UINT32_MAX;
+    // Enough for a typical request or response without allocating
+    static constexpr size_t kInlineFields = 12;
+    
+    HeaderField* fields() { return spilled_ ? overflow_.data() : inline_.data(); }
+    const HeaderField* fields() const { return spilled_ ? overflow_.data() : inline_.data(); }
+    void push(HeaderField field);
+    void truncate(size_t count);
+    
+    size_t indexOf(std::string_view name, HeaderId id) const;
+    void append(HeaderId id, std::string_view name, std::string value);
+    void assign(HeaderId id, std::string_view name, std::string value);
+    size_t eraseMatching(HeaderId id, std::string_view name);
+    void reindex();
+    
+    // The fields are inline_[0, count_), or all of overflow_ once spilled_
+    std::array<HeaderField, kInlineFields> inline_;
+    std::vector<HeaderField> overflow_;
+    size_t count_ = 0;
+    bool spilled_ = false;
+    // Index of the first field with each well-known id, or kNoField
+    std::array<uint32_t, kKnownCount> first_;
+    // Bit per id that occurs more than once, so set() can skip the scan
+    uint64_t repeated_ = 0;
+};
+
+} // namespace httpapi 
@@ -14,6 +14,7 @@
 #include "response.hpp"
 #include "router.hpp"
 #include "middleware.hpp"
+#include "static_files.hpp"
 
 namespace httpapi {
 
@@ -36,12 +37,20 @@ public:
     HttpServer& delete_(const std::string& path, RequestHandler handler);
     HttpServer& patch(const std::string& path, RequestHandler handler);
     
-    // Middleware support
+    // Routes may be added or removed while the server is running
+    bool removeRoute(const std::string& method, const std::string& path);
+    
+    // Middleware support (register before start(); chains are compiled per route there)
     HttpServer& use(MiddlewareFunction middleware);
     HttpServer& use(const std::string& path, MiddlewareFunction middleware);
     
     // Static file serving
-    HttpServer& static_(const std::string& path, const std::string& directory);
+    HttpServer& static_(const std::string& path, const std::string& directory,
+                        const StaticFileOptions& options = StaticFileOptions());
+    
+    // Fingerprinted URL of a static asset (StaticFileOptions::fingerprint),
+    // for emitting cache-busting links from templates
+    std::string assetUrl(const std::string& path) const;
     
     // Server control
     void start();
@@ -52,7 +61,8 @@ private:
     void handleClient(SOCKET clientSocket);
     void processRequest(Request& req, Response& res);
     std::string readRequest(SOCKET socket);
-    void sendResponse(SOCKET socket, const std::string& response);
+    bool sendResponse(SOCKET socket, std::string_view response);
+    void sendStream(SOCKET socket, Response::StreamProducer& producer, bool chunked);
     
     // Server state
     SOCKET serverSocket_;
@@ -66,10 +76,11 @@ private:
     
     // Router and middleware
     std::unique_ptr<Router> router_;
-    std::vector<MiddlewareFunction> globalMiddleware_;
+    std::unique_ptr<Middleware> middleware_;
+    RequestHandler notFoundHandler_;
     
-    // Static file configuration
-    std::unordered_map<std::string, std::string> staticPaths_;
+    // Static file serving (long-lived so its file cache survives across requests)
+    std::unique_ptr<StaticFileHandler> staticFiles_;
     
     // Initialize Winsock
     bool initializeWinsock();
@@ -0,0 +1,347 @@
+#pragma once
+
+#include "json_reader.hpp"
+#include "json_writer.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <optional>
+#include <tuple>
+#include <limits>
+#include <type_traits>
+#include <stdexcept>
+#include <utility>
+
+// Binds a struct's members to a JSON object of the same field names:
+//
+//     struct User {
+//         int64_t id = 0;
+//         std::string name;
+//         std::optional<std::string> email;
+//         std::vector<std::string> tags;
+//     };
+//     HTTPAPI_JSON_FIELDS(User, id, name, email, tags)
+//
+// Place it at namespace scope next to the struct (it is found by ADL). It
+// generates a direct decoder and encoder; see fromJson(), toJson(),
+// Request::getBody<T>() and Response::json(const T&). For other JSON names,
+// write the function the macro expands to by hand:
+//
+//     inline auto httpapiJsonFields(const User*) {
+//         return std::make_tuple(httpapi::jsonField("user_id", &User::id), ...);
+//     }
+#define HTTPAPI_JSON_FIELDS(Type, ...) \
+    inline auto httpapiJsonFields(const Type*) { \
+        return std::make_tuple(HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_CONCAT(HTTPAPI_JSON_MAP_, \
+            HTTPAPI_JSON_COUNT(__VA_ARGS__))(HTTPAPI_JSON_FIELD, Type, __VA_ARGS__))); \
+    }
+
+#define HTTPAPI_JSON_FIELD(Type, member) ::httpapi::jsonField(#member, &Type::member)
+
+// Up to 32 fields per struct
+#define HTTPAPI_JSON_EXPAND(x) x
+#define HTTPAPI_JSON_COUNT_N(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
+#define HTTPAPI_JSON_COUNT(...) HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_COUNT_N(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1))
+#define HTTPAPI_JSON_CONCAT_(a, b) a##b
+#define HTTPAPI_JSON_CONCAT(a, b) HTTPAPI_JSON_CONCAT_(a, b)
+#define HTTPAPI_JSON_MAP_1(m, T, a) m(T, a)
+#define HTTPAPI_JSON_MAP_2(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_1(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_3(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_2(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_4(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_3(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_5(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_4(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_6(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_5(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_7(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_6(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_8(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_7(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_9(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_8(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_10(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_9(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_11(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_10(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_12(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_11(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_13(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_12(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_14(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_13(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_15(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_14(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_16(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_15(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_17(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_16(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_18(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_17(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_19(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_18(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_20(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_19(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_21(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_20(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_22(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_21(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_23(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_22(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_24(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_23(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_25(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_24(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_26(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_25(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_27(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_26(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_28(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_27(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_29(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_28(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_30(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_29(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_31(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_30(m, T, __VA_ARGS__))
+#define HTTPAPI_JSON_MAP_32(m, T, a, ...) m(T, a), HTTPAPI_JSON_EXPAND(HTTPAPI_JSON_MAP_31(m, T, __VA_ARGS__))
+
+namespace httpapi {
+
+template<typename Class, typename Member>
+struct JsonField {
+    std::string_view name;
+    Member Class::*member;
+};
+
+template<typename Class, typename Member>
+constexpr JsonField<Class, Member> jsonField(std::string_view name, Member Class::*member) {
+    return JsonField<Class, Member>{name, member};
+}
+
+// How a C++ type is read from and written to JSON. Specialize it for types
+// that cannot use HTTPAPI_JSON_FIELDS:
+//
+//     static void read(JsonReader& reader, JsonToken token, T& out); // token starts the value
+//     static void write(JsonWriter& writer, const T& value);
+template<typename T, typename = void>
+struct JsonCodec;
+
+namespace detail {
+
+template<typename T, typename = void>
+struct HasJsonFields : std::false_type {};
+
+template<typename T>
+struct HasJsonFields<T, std::void_t<decltype(httpapiJsonFields(static_cast<const T*>(nullptr)))>>
+    : std::true_type {};
+
+template<typename T, typename = void>
+struct HasJsonCodec : std::false_type {};
+
+template<typename T>
+struct HasJsonCodec<T, std::void_t<decltype(&JsonCodec<T>::write)>> : std::true_type {};
+
+// The whole input is fed up front, so running out of tokens is an error
+inline JsonToken nextJsonToken(JsonReader& reader) {
+    JsonToken token = reader.next();
+    if (token == JsonToken::NeedMore || token == JsonToken::End) {
+        throw std::runtime_error("Invalid JSON at offset " + std::to_string(reader.offset()) +
+                                 ": unexpected end of input");
+    }
+    return token;
+}
+
+[[noreturn]] inline void jsonTypeError(const JsonReader& reader, const char* expected) {
+    throw std::runtime_error("JSON value at offset " + std::to_string(reader.offset()) +
+                             " is not " + expected);
+}
+
+template<typename Class, typename Member>
+bool readJsonField(JsonReader& reader, std::string_view key,
+                   const JsonField<Class, Member>& field, Class& out) {
+    if (field.name != key) {
+        return false;
+    }
+    JsonCodec<Member>::read(reader, nextJsonToken(reader), out.*field.member);
+    return true;
+}
+
+} // namespace detail
+
+template<typename T>
+constexpr bool isJsonBound = detail::HasJsonFields<T>::value;
+
+template<typename T>
+constexpr bool isJsonSerializable = detail::HasJsonCodec<T>::value;
+
+template<>
+struct JsonCodec<bool> {
+    static void read(JsonReader& reader, JsonToken token, bool& out) {
+        if (token != JsonToken::Boolean) {
+            detail::jsonTypeError(reader, "a boolean");
+        }
+        out = reader.boolean();
+    }
+    static void write(JsonWriter& writer, bool value) { writer.value(value); }
+};
+
+template<typename T>
+struct JsonCodec<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>> {
+    static void read(JsonReader& reader, JsonToken token, T& out) {
+        if (token != JsonToken::Number || !reader.isInteger()) {
+            detail::jsonTypeError(reader, "an integer");
+        }
+        if constexpr (std::is_signed_v<T>) {
+            int64_t value = reader.integer();
+            if (value < static_cast<int64_t>(std::numeric_limits<T>::min()) ||
+                value > static_cast<int64_t>(std::numeric_limits<T>::max())) {
+                detail::jsonTypeError(reader, "in range");
+            }
+            out = static_cast<T>(value);
+        } else {
+            // Parsed unsigned so the upper half of uint64_t is accepted
+            uint64_t value = reader.unsignedInteger();
+            if (value > static_cast<uint64_t>(std::numeric_limits<T>::max())) {
+                detail::jsonTypeError(reader, "in range");
+            }
+            out = static_cast<T>(value);
+        }
+    }
+    static void write(JsonWriter& writer, T value) { writer.value(value); }
+};
+
+template<typename T>
+struct JsonCodec<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+    static void read(JsonReader& reader, JsonToken token, T& out) {
+        if (token != JsonToken::Number) {
+            detail::jsonTypeError(reader, "a number");
+        }
+        out = static_cast<T>(reader.number());
+    }
+    static void write(JsonWriter& writer, T value) { writer.value(static_cast<double>(value)); }
+};
+
+template<>
+struct JsonCodec<std::string> {
+    static void read(JsonReader& reader, JsonToken token, std::string& out) {
+        if (token != JsonToken::String) {
+            detail::jsonTypeError(reader, "a string");
+        }
+        out.assign(reader.text().data(), reader.text().size());
+    }
+    static void write(JsonWriter& writer, const std::string& value) { writer.value(value); }
+};
+
+// null or a missing member leaves it empty
+template<typename T>
+struct JsonCodec<std::optional<T>> {
+    static void read(JsonReader& reader, JsonToken token, std::optional<T>& out) {
+        if (token == JsonToken::Null) {
+            out.reset();
+            return;
+        }
+        JsonCodec<T>::read(reader, token, out.emplace());
+    }
+    static void write(JsonWriter& writer, const std::optional<T>& value) {
+        if (value) {
+            JsonCodec<T>::write(writer, *value);
+        } else {
+            writer.null();
+        }
+    }
+};
+
+template<typename T>
+struct JsonCodec<std::vector<T>> {
+    static void read(JsonReader& reader, JsonToken token, std::vector<T>& out) {
+        if (token != JsonToken::StartArray) {
+            detail::jsonTypeError(reader, "an array");
+        }
+        out.clear();
+        while ((token = detail::nextJsonToken(reader)) != JsonToken::EndArray) {
+            // Not out.back(): std::vector<bool> hands out a proxy
+            T item{};
+            JsonCodec<T>::read(reader, token, item);
+            out.push_back(std::move(item));
+        }
+    }
+    // Large arrays are serialized in parallel (see JsonWriter::parallelArray)
+    static void write(JsonWriter& writer, const std::vector<T>& value) {
+        writer.parallelArray(value.size(), [&value](JsonWriter& itemWriter, size_t index) {
+            JsonCodec<T>::write(itemWriter, value[index]);
+        });
+    }
+};
+
+namespace detail {
+
+// std::map / std::unordered_map with string keys <-> JSON object
+template<typename Map>
+struct JsonMapCodec {
+    using Value = typename Map::mapped_type;
+    
+    static void read(JsonReader& reader, JsonToken token, Map& out) {
+        if (token != JsonToken::StartObject) {
+            jsonTypeError(reader, "an object");
+        }
+        out.clear();
+        while (nextJsonToken(reader) == JsonToken::Key) {
+            Value& value = out[std::string(reader.text())];
+            JsonCodec<Value>::read(reader, nextJsonToken(reader), value);
+        }
+    }
+    static void write(JsonWriter& writer, const Map& value) {
+        writer.beginObject();
+        for (const auto& pair : value) {
+            writer.key(pair.first);
+            JsonCodec<Value>::write(writer, pair.second);
+        }
+        writer.endObject();
+    }
+};
+
+} // namespace detail
+
+template<typename T>
+struct JsonCodec<std::map<std::string, T>> : detail::JsonMapCodec<std::map<std::string, T>> {};
+
+template<typename T>
+struct JsonCodec<std::unordered_map<std::string, T>>
+    : detail::JsonMapCodec<std::unordered_map<std::string, T>> {};
+
+// Structs declared with HTTPAPI_JSON_FIELDS. Unknown members are skipped;
+// members absent from the JSON keep their default value.
+template<typename T>
+struct JsonCodec<T, std::enable_if_t<detail::HasJsonFields<T>::value>> {
+    static void read(JsonReader& reader, JsonToken token, T& out) {
+        if (token != JsonToken::StartObject) {
+            detail::jsonTypeError(reader, "an object");
+        }
+        const auto fields = httpapiJsonFields(static_cast<const T*>(nullptr));
+        while (detail::nextJsonToken(reader) == JsonToken::Key) {
+            std::string_view key = reader.text();
+            bool matched = std::apply([&](const auto&... field) {
+                return (detail::readJsonField(reader, key, field, out) || ...);
+            }, fields);
+            if (!matched) {
+                reader.skip();
+            }
+        }
+    }
+    static void write(JsonWriter& writer, const T& value) {
+        const auto fields = httpapiJsonFields(static_cast<const T*>(nullptr));
+        writer.beginObject();
+        std::apply([&](const auto&... field) {
+            ((writer.key(field.name), writeMember(writer, value.*field.member)), ...);
+        }, fields);
+        writer.endObject();
+    }
+    
+private:
+    template<typename Member>
+    static void writeMember(JsonWriter& writer, const Member& member) {
+        JsonCodec<Member>::write(writer, member);
+    }
+};
+
+// Decode straight into T without building a tree. Throws std::runtime_error
+// on malformed JSON or a type mismatch.
+template<typename T>
+T fromJson(std::string_view json) {
+    JsonReader reader;
+    reader.feed(json);
+    reader.finish();
+    T value{};
+    JsonCodec<T>::read(reader, detail::nextJsonToken(reader), value);
+    reader.next(); // End, or throws on trailing characters
+    return value;
+}
+
+template<typename T>
+void toJson(const T& value, std::string& out) {
+    JsonWriter writer(out);
+    JsonCodec<T>::write(writer, value);
+}
+
+template<typename T>
+std::string toJson(const T& value) {
+    std::string out;
+    toJson(value, out);
+    return out;
+}
+
+} // namespace httpapi 
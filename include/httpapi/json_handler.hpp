@@ -19,8 +19,9 @@ public:
     static std::string stringify(const std::vector<std::string>& array);
     static std::string stringify(const std::vector<std::unordered_map<std::string, std::any>>& array);
     
-    // Validation
-    static bool isValid(const std::string& json);
+    // Validation; accepts what parse() accepts, and with validateUtf8 also
+    // requires well-formed UTF-8
+    static bool isValid(const std::string& json, bool validateUtf8 = false);
     
 private:
     // Helper methods for JSON parsing
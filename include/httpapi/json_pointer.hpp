@@ -0,0 +1,83 @@
+#pragma once
+
+#include "json_value.hpp"
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+namespace httpapi {
+
+// One JSON value located inside a larger text, left undecoded until an
+// accessor is called. An empty slice means the value was not found.
+// Accessors throw std::runtime_error on a missing value or a type mismatch.
+class JsonSlice {
+public:
+    JsonSlice() = default;
+    explicit JsonSlice(std::string_view raw) : raw_(raw) {}
+    
+    bool found() const { return !raw_.empty(); }
+    explicit operator bool() const { return found(); }
+    
+    // The value's JSON text, exactly as it appears in the source
+    std::string_view raw() const { return raw_; }
+    JsonType type() const;
+    
+    bool isNull() const { return found() && type() == JsonType::Null; }
+    bool asBool() const;
+    double asNumber() const;
+    int64_t asInt() const;
+    std::string asString() const;
+    
+    // Materialize the value (and everything under it) as a document
+    JsonDocument parse() const;
+    
+private:
+    void expect(JsonType expected) const;
+    
+    std::string_view raw_;
+};
+
+// Looks values up in a JSON text by JSON Pointer (RFC 6901), e.g.
+// "/tenant/id" or "/items/0/sku", without parsing the text as a whole.
+// Members and elements before the target are stepped over by bracket
+// matching only, and every value passed on the way is remembered, so
+// repeated or neighbouring lookups scan only text not seen before.
+//
+// Only scanned text is checked, and only loosely; use JsonDocument when the
+// whole body must be validated.
+class JsonPointerIndex {
+public:
+    // An empty slice when the pointer does not resolve; slices point into
+    // `json`. Cached positions are kept as offsets and reused for every call
+    // until clear(), which the caller must invoke when the text changes
+    // (Request::setBody does). Throws std::runtime_error on a malformed
+    // pointer or malformed JSON.
+    JsonSlice find(std::string_view json, std::string_view pointer);
+    
+    void clear();
+    
+private:
+    struct Span {
+        size_t offset;
+        size_t length;
+    };
+    
+    // How far a container's children have been scanned
+    struct Cursor {
+        size_t next;
+        size_t index;
+        bool complete;
+    };
+    
+    bool scanFor(const std::string& parentPath, const Span& parent,
+                 std::string_view token, Span& found);
+    
+    std::string_view json_; // the text of the current call
+    size_t size_ = 0;       // length of the text the cache was built for
+    std::unordered_map<std::string, Span> values_;   // by pointer
+    std::unordered_map<std::string, Cursor> cursors_; // by container pointer
+};
+
+} // namespace httpapi 
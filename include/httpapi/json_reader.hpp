@@ -0,0 +1,120 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+namespace httpapi {
+
+enum class JsonToken : uint8_t {
+    NeedMore,     // feed() more input (or finish()) and call next() again
+    StartObject,
+    EndObject,
+    StartArray,
+    EndArray,
+    Key,
+    String,
+    Number,
+    Boolean,
+    Null,
+    End           // the document is complete
+};
+
+// Pull parser for JSON that arrives in pieces. Input is fed chunk by chunk
+// and next() returns one token at a time without building a tree; only the
+// token currently being read is buffered, so memory stays bounded by the
+// limits however large the document is.
+//
+//     JsonReader reader;
+//     reader.feed(chunk);            // as often as data arrives
+//     reader.finish();               // after the last chunk
+//     for (JsonToken t; (t = reader.next()) != JsonToken::End;) {
+//         if (t == JsonToken::NeedMore) { /* feed more */ }
+//         if (t == JsonToken::Key && reader.text() != "id") reader.skip();
+//     }
+//
+// Errors and exceeded limits throw std::runtime_error with the byte offset.
+class JsonReader {
+public:
+    struct Limits {
+        size_t maxDepth = 64;
+        size_t maxTokenSize = 1024 * 1024; // longest string or number, as written
+        size_t maxDocumentSize = 0;        // total bytes fed; 0 for no limit
+    };
+    
+    JsonReader();
+    explicit JsonReader(const Limits& limits);
+    
+    void feed(std::string_view chunk);
+    // No more input will follow
+    void finish();
+    
+    JsonToken next();
+    
+    // After StartObject/StartArray: skip the rest of that container. After
+    // Key: skip its value. Skipped bytes are only checked for balanced
+    // brackets and strings, which is much cheaper than tokenizing them.
+    void skip();
+    
+    // Key and String: the decoded text. Number: the literal as written.
+    // Valid until the next call to next() or feed().
+    std::string_view text() const { return text_; }
+    bool boolean() const { return boolean_; }
+    bool isInteger() const { return integral_; }
+    double number() const;
+    int64_t integer() const; // throws unless isInteger() and in range
+    uint64_t unsignedInteger() const; // likewise, and for negative values
+    
+    size_t depth() const { return stack_.size(); }
+    // Bytes of input consumed so far
+    size_t offset() const { return consumed_ + pos_; }
+
+private:
+    enum class State : uint8_t {
+        Value,
+        ValueOrEnd,  // just after '['
+        Key,
+        KeyOrEnd,    // just after '{'
+        Colon,
+        CommaOrEnd,
+        Done
+    };
+    
+    [[noreturn]] void fail(const char* message) const;
+    JsonToken token(JsonToken t) { last_ = t; return t; }
+    JsonToken readValue(char c);
+    JsonToken closeContainer(char c);
+    void pushContainer(char c);
+    void afterValue() { state_ = stack_.empty() ? State::Done : State::CommaOrEnd; }
+    bool readString();
+    bool readNumber();
+    bool readLiteral(const char* word, size_t length);
+    bool skipContainer();
+    
+    Limits limits_;
+    std::string buffer_;
+    size_t pos_;
+    size_t consumed_;
+    size_t fed_;
+    bool finished_;
+    State state_;
+    std::string stack_; // '{' or '[' per open container
+    JsonToken last_;
+    
+    std::string_view text_;
+    std::string decoded_;
+    bool boolean_;
+    bool integral_;
+    
+    // Resume point inside a string split across chunks
+    size_t scan_;
+    bool scanEscapes_;
+    
+    size_t skipDepth_;
+    bool skipInString_;
+    bool skipEscape_;
+    bool skipValue_;
+};
+
+} // namespace httpapi 
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace httpapi {
+
+// String-level JSON primitives shared by JsonWriter, JsonReader and
+// JsonHandler. Scanning runs 32 bytes at a time with AVX2 or 16 with SSE2
+// (chosen at runtime) or a byte loop on other CPUs, so runs of plain text
+// are found in bulk and copied with a single append.
+class JsonString {
+public:
+    // First byte in [first, last) that cannot appear unescaped inside a JSON
+    // string ('"', '\\' or a control character), or last if there is none
+    static const char* findSpecial(const char* first, const char* last);
+    
+    // Append `text` as the contents of a JSON string literal (no quotes)
+    static void escape(std::string_view text, std::string& out);
+    
+    // Decode the contents of a JSON string literal (no quotes) onto `out`.
+    // \u escapes become UTF-8, with surrogate pairs combined. Returns nullptr
+    // on success or a description of the first malformed escape.
+    static const char* unescape(std::string_view raw, std::string& out);
+    
+    // Well-formed UTF-8: no stray continuation bytes, truncated or overlong
+    // sequences, surrogates, or code points above U+10FFFF
+    static bool isValidUtf8(std::string_view text);
+    
+    // "avx2", "sse2" or "scalar"
+    static const char* implementation();
+    
+    // Whether the CPU and OS support AVX2. The one check behind every
+    // runtime-dispatched JSON scanner, so they all pick the same path.
+    static bool cpuHasAvx2();
+};
+
+} // namespace httpapi 
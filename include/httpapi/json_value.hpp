@@ -0,0 +1,179 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace httpapi {
+
+// Bump allocator backing a JsonDocument. Memory is handed out from a few
+// large blocks and released all at once with the arena.
+class JsonArena {
+public:
+    explicit JsonArena(size_t firstBlockSize = 4096);
+    
+    JsonArena(JsonArena&&) noexcept = default;
+    JsonArena& operator=(JsonArena&&) noexcept = default;
+    
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    
+    template<typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+    
+    // Bytes reserved from the system so far
+    size_t capacity() const { return capacity_; }
+    size_t blockCount() const { return blocks_.size(); }
+
+private:
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* cursor_;
+    char* end_;
+    size_t nextBlockSize_;
+    size_t capacity_;
+};
+
+enum class JsonType : uint8_t {
+    Null,
+    Boolean,
+    Number,
+    String,
+    Array,
+    Object
+};
+
+class JsonValue;
+struct JsonMember;
+
+// Contiguous run of array elements or object members
+template<typename T>
+class JsonRange {
+public:
+    JsonRange(const T* first, size_t count) : first_(first), count_(count) {}
+    
+    const T* begin() const { return first_; }
+    const T* end() const { return first_ + count_; }
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    const T& operator[](size_t index) const { return first_[index]; }
+
+private:
+    const T* first_;
+    size_t count_;
+};
+
+// Immutable JSON value: a 16-byte tagged union whose strings, elements and
+// members live in the owning JsonDocument's arena. Strings of up to 8 bytes
+// are stored inline. Object members keep their document order.
+//
+// Accessors are checked and throw std::runtime_error on a type mismatch,
+// a missing key or an out-of-range index.
+class JsonValue {
+public:
+    JsonValue();
+    
+    JsonType type() const { return type_; }
+    bool isNull() const { return type_ == JsonType::Null; }
+    bool isBool() const { return type_ == JsonType::Boolean; }
+    bool isNumber() const { return type_ == JsonType::Number; }
+    bool isInteger() const { return type_ == JsonType::Number && (flags_ & kInteger); }
+    bool isString() const { return type_ == JsonType::String; }
+    bool isArray() const { return type_ == JsonType::Array; }
+    bool isObject() const { return type_ == JsonType::Object; }
+    
+    bool asBool() const;
+    double asNumber() const;
+    int64_t asInt() const; // only for numbers written without fraction or exponent
+    std::string_view asString() const;
+    JsonRange<JsonValue> asArray() const;
+    JsonRange<JsonMember> asObject() const;
+    
+    // Elements, members or string bytes; 0 for scalars
+    size_t size() const;
+    
+    const JsonValue& operator[](size_t index) const;
+    const JsonValue& operator[](std::string_view key) const;
+    
+    // nullptr when this is not an object or has no such key
+    const JsonValue* find(std::string_view key) const;
+    bool contains(std::string_view key) const { return find(key) != nullptr; }
+    
+    static const char* typeName(JsonType type);
+
+private:
+    friend class JsonDocument;
+    
+    static constexpr uint8_t kInteger = 1;
+    static constexpr uint8_t kInline = 2;
+    static constexpr size_t kInlineCapacity = 8;
+    
+    [[noreturn]] void typeError(JsonType expected) const;
+    
+    union {
+        bool boolean_;
+        double number_;
+        int64_t integer_;
+        const char* chars_;
+        const JsonValue* items_;
+        const JsonMember* members_;
+        char inline_[kInlineCapacity];
+    };
+    uint32_t size_;
+    JsonType type_;
+    uint8_t flags_;
+};
+
+struct JsonMember {
+    JsonValue key;
+    JsonValue value;
+    
+    std::string_view name() const { return key.asString(); }
+};
+
+// Stage 1 of JsonDocument::parse: the offset of every operator, string start
+// and scalar start, found 64 bytes at a time with AVX2 or SSE2 (chosen at
+// runtime) or a scalar loop on other CPUs. Escaped quotes and everything
+// inside strings are masked out, so the parser never rescans whitespace.
+class JsonStructuralIndex {
+public:
+    // Throws std::runtime_error on an unterminated string
+    static void build(const char* data, size_t size, std::vector<uint32_t>& positions);
+    
+    // "avx2", "sse2" or "scalar"
+    static const char* implementation();
+};
+
+// A parsed JSON text. Owns every value reachable from root(); values must not
+// outlive the document. Parsing copies the input once into the arena, so the
+// source buffer can be released straight away.
+class JsonDocument {
+public:
+    JsonDocument();
+    
+    JsonDocument(JsonDocument&&) noexcept = default;
+    JsonDocument& operator=(JsonDocument&&) noexcept = default;
+    
+    // Throws std::runtime_error with the byte offset of the first error.
+    // Strings are copied byte for byte; pass validateUtf8 to also reject
+    // input that is not well-formed UTF-8 (checked up front, 32 bytes at a
+    // time where AVX2 is available).
+    static JsonDocument parse(std::string_view json, bool validateUtf8 = false);
+    
+    const JsonValue& root() const { return root_; }
+    const JsonValue& operator[](std::string_view key) const { return root_[key]; }
+    const JsonValue& operator[](size_t index) const { return root_[index]; }
+    
+    const JsonArena& arena() const { return arena_; }
+
+private:
+    struct Parser;
+    
+    JsonArena arena_;
+    JsonValue root_;
+};
+
+} // namespace httpapi 
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+namespace httpapi {
+
+class ThreadPool;
+
+// Streaming JSON serializer that appends straight onto a caller-owned string,
+// typically a Response body:
+//
+//     JsonWriter json(out);
+//     json.beginObject();
+//     json.member("id", 42).member("name", name);
+//     json.key("tags").beginArray().value("a").value("b").endArray();
+//     json.endObject();
+//
+// Commas and colons are inserted automatically. Misuse (a value with no key
+// inside an object, mismatched end calls) throws std::runtime_error.
+// Non-finite doubles have no JSON spelling and are written as null.
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& out) : out_(out), needComma_(false), afterKey_(false) {}
+    
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+    
+    JsonWriter& key(std::string_view name);
+    
+    JsonWriter& value(std::string_view text);
+    JsonWriter& value(const char* text) { return value(std::string_view(text)); }
+    JsonWriter& value(const std::string& text) { return value(std::string_view(text)); }
+    JsonWriter& value(bool flag);
+    JsonWriter& value(double number);
+    JsonWriter& value(std::nullptr_t) { return null(); }
+    
+    template<typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+    JsonWriter& value(T number) {
+        if constexpr (std::is_signed_v<T>) {
+            return writeInteger(static_cast<int64_t>(number));
+        } else {
+            return writeUnsigned(static_cast<uint64_t>(number));
+        }
+    }
+    
+    JsonWriter& null();
+    
+    // Already-serialized JSON, copied verbatim as one value
+    JsonWriter& raw(std::string_view json);
+    
+    template<typename T>
+    JsonWriter& member(std::string_view name, const T& v) {
+        key(name);
+        return value(v);
+    }
+    
+    // Writes an array of `count` elements, writeItem(writer, i) producing
+    // element i. Arrays of at least kParallelThreshold elements are split
+    // into chunks serialized concurrently on `pool` (the calling thread
+    // helps) and stitched together in order, so writeItem must be safe to
+    // call from several threads at once. Smaller arrays are written inline.
+    using ItemWriter = std::function<void(JsonWriter& writer, size_t index)>;
+    JsonWriter& parallelArray(size_t count, const ItemWriter& writeItem);
+    JsonWriter& parallelArray(size_t count, const ItemWriter& writeItem, ThreadPool& pool);
+    
+    static constexpr size_t kParallelThreshold = 4096;
+    
+    // True once a complete top-level value has been written
+    bool complete() const { return stack_.empty() && needComma_; }
+    
+    // Appends `text` JSON-escaped (without quotes). Clean runs are copied in
+    // bulk; only quotes, backslashes and control characters are rewritten.
+    static void escape(std::string_view text, std::string& out);
+    
+private:
+    void prefix();
+    JsonWriter& writeInteger(int64_t number);
+    JsonWriter& writeUnsigned(uint64_t number);
+    JsonWriter& serialArray(size_t count, const ItemWriter& writeItem);
+    
+    std::string& out_;
+    std::string stack_; // '{' or '[' per open container
+    bool needComma_;
+    bool afterKey_;
+};
+
+} // namespace httpapi 
@@ -4,6 +4,7 @@
 #include <functional>
 #include <vector>
 #include <memory>
+#include <cstdint>
 
 #include "request.hpp"
 #include "response.hpp"
@@ -13,16 +14,33 @@ namespace httpapi {
 class Middleware {
 public:
     using MiddlewareFunction = std::function<void(Request&, Response&, std::function<void()>)>;
+    using Handler = std::function<void(Request&, Response&)>;
+    
+    // Middleware precomputed for one route. Entries whose path scope cannot
+    // match the route are dropped; entries that can only be decided from the
+    // concrete request path keep a per-request prefix check.
+    struct Chain {
+        struct Step {
+            uint32_t index;
+            bool checkPath;
+        };
+        std::vector<Step> steps;
+    };
     
     Middleware();
     ~Middleware();
     
-    // Add middleware
+    // Add middleware (register all middleware before compiling chains)
     void use(MiddlewareFunction middleware);
     void use(const std::string& path, MiddlewareFunction middleware);
     
+    // Build the chain for a route path such as "/api/users/:id"
+    Chain compile(const std::string& routePath) const;
+    
     // Execute middleware chain
     void execute(Request& req, Response& res, std::function<void()> next);
+    void execute(Request& req, Response& res, const Handler& handler) const;
+    void execute(const Chain& chain, Request& req, Response& res, const Handler& handler) const;
     
     // Clear all middleware
     void clear();
@@ -42,10 +60,10 @@ private:
     std::vector<MiddlewareEntry> middlewareChain_;
     
     // Helper methods
-    bool pathMatches(const std::string& middlewarePath, const std::string& requestPath);
-    void executeNext(Request& req, Response& res, 
-                    std::vector<MiddlewareEntry>::iterator current,
-                    std::function<void()> finalNext);
+    static bool pathMatches(const std::string& middlewarePath, const std::string& requestPath);
+    
+    template<typename Terminal>
+    friend class ChainRunner;
 };
 
-} // namespace httpapi 
\ No newline at end of file
+} // namespace httpapi 
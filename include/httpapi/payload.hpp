@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <any>
+
+namespace httpapi {
+
+class Request;
+class Response;
+
+enum class PayloadFormat {
+    Json,
+    MessagePack,
+    Cbor
+};
+
+// MessagePack and CBOR for the JsonHandler value model: string-keyed maps of
+// std::any holding strings, numbers, bools, nested maps, std::vector<std::any>
+// and empty std::any for null. Encoders accept the same types as
+// JsonHandler::stringify (anything else is written as null); floats that a
+// float32 represents exactly are written in 4 bytes.
+//
+// Decoders return integers as int64_t (uint64_t above its range), floats as
+// double and binary strings as std::string. They throw std::runtime_error
+// on malformed input, unsupported types (extensions), non-string map keys,
+// nesting deeper than 64 levels or a top level that is not a map.
+class MessagePack {
+public:
+    static std::string encode(const std::unordered_map<std::string, std::any>& data);
+    static std::string encode(const std::vector<std::unordered_map<std::string, std::any>>& array);
+    static std::unordered_map<std::string, std::any> decode(std::string_view data);
+};
+
+// CBOR (RFC 8949). Definite lengths are written; indefinite-length items,
+// half-precision floats and tags (skipped, keeping the tagged value) are
+// also read.
+class Cbor {
+public:
+    static std::string encode(const std::unordered_map<std::string, std::any>& data);
+    static std::string encode(const std::vector<std::unordered_map<std::string, std::any>>& array);
+    static std::unordered_map<std::string, std::any> decode(std::string_view data);
+};
+
+// Content negotiation between JSON and the binary formats, so one handler
+// serves browsers and internal callers alike:
+//
+//     app.get("/api/users/:id", [](Request& req, Response& res) {
+//         Payload::send(req, res, loadUser(req.param("id")));
+//     });
+class Payload {
+public:
+    // Best format for an Accept header. Binary formats are only chosen when
+    // named explicitly; wildcards, a missing header or nothing acceptable
+    // mean JSON. On equal q-values MessagePack wins over CBOR over JSON.
+    static PayloadFormat negotiate(const std::string& accept);
+    
+    // Format named by a Content-Type header (JSON when unrecognized)
+    static PayloadFormat formatOf(const std::string& contentType);
+    
+    // Content-Type to send ("application/json", "application/msgpack", "application/cbor")
+    static const char* mediaType(PayloadFormat format);
+    
+    static std::string encode(const std::unordered_map<std::string, std::any>& data, PayloadFormat format);
+    static std::string encode(const std::vector<std::unordered_map<std::string, std::any>>& array,
+                              PayloadFormat format);
+    static std::unordered_map<std::string, std::any> decode(std::string_view body, PayloadFormat format);
+    
+    // The request body, decoded according to its Content-Type
+    static std::unordered_map<std::string, std::any> parse(const Request& req);
+    
+    // Encode for the request's Accept header and send it with a matching
+    // Content-Type; "Vary: Accept" is added so caches keep the variants apart
+    static void send(const Request& req, Response& res, const std::unordered_map<std::string, std::any>& data);
+    static void send(const Request& req, Response& res,
+                     const std::vector<std::unordered_map<std::string, std::any>>& array);
+};
+
+} // namespace httpapi 
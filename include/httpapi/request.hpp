@@ -5,6 +5,11 @@
 #include <vector>
 #include <memory>
 #include <any>
+#include "headers.hpp"
+#include "json_binding.hpp"
+#include "json_pointer.hpp"
+#include "request_context.hpp"
+#include "url_encoded.hpp"
 
 namespace httpapi {
 
@@ -19,25 +24,53 @@ public:
     std::string queryString;
     std::string protocol;
     
-    // Headers
-    std::unordered_map<std::string, std::string> headers;
+    // Headers, in the order received; repeated names are kept
+    Headers headers;
     
     // Body
     std::string body;
     
-    // Parameters (from URL and body)
+    // Route parameters
     std::unordered_map<std::string, std::string> params;
-    std::unordered_map<std::string, std::string> queryParams;
     
     // Express.js style properties
     std::string get(const std::string& header) const;
     std::string param(const std::string& name) const;
+    
+    // Query string and urlencoded form fields are split on first use and
+    // decoded only when escaped. query()/form() return the first value for
+    // a repeated key (empty when absent); the *All variants return every
+    // value, as views valid until queryString or body changes. Replace them
+    // with setQueryString()/setBody() once fields have been looked up, so
+    // the split fields are dropped.
     std::string query(const std::string& name) const;
+    std::vector<std::string_view> queryAll(const std::string& name) const;
+    std::string form(const std::string& name) const;
+    std::vector<std::string_view> formAll(const std::string& name) const;
     
-    // Body parsing
+    // Body parsing: the raw body for std::string, a direct decode for
+    // JSON-bound types (see HTTPAPI_JSON_FIELDS), which throws
+    // std::runtime_error on malformed or mismatched JSON
     template<typename T>
     T getBody() const;
     
+    // One value of a JSON body by JSON Pointer, e.g. jsonPointer("/tenant/id").
+    // Only the body up to that value is scanned, and the positions found on
+    // the way are kept on the request for later lookups.
+    JsonSlice jsonPointer(std::string_view pointer) const;
+    
+    // Replace the query string or body and drop everything looked up in
+    // the old one
+    void setQueryString(std::string newQueryString);
+    void setBody(std::string newBody);
+    
+    // Typed per-request values set by middleware (see RequestContext); the
+    // T is default-constructed on first access
+    template<typename T>
+    T& ctx() { return context_.get<T>(); }
+    RequestContext& context() { return context_; }
+    const RequestContext& context() const { return context_; }
+    
     // Utility methods
     bool is(const std::string& type) const;
     std::string getContentType() const;
@@ -45,19 +78,35 @@ public:
     
     // Internal use
     void setParam(const std::string& name, const std::string& value);
-    void setQueryParam(const std::string& name, const std::string& value);
-    void parseQueryString();
-    void parseBody();
+    
+    // Change the path (and method) the request is routed by. Middleware that
+    // rewrites a request must go through these rather than assign the
+    // fields, so the router knows to pick the handler again.
+    void rewrite(std::string newPath);
+    void rewrite(std::string newMethod, std::string newPath);
+    unsigned rewriteCount() const { return rewrites_; }
     
 private:
-    std::unordered_map<std::string, std::any> locals_;
+    bool isForm() const;
+    
+    unsigned rewrites_ = 0;
+    RequestContext context_;
+    mutable JsonPointerIndex jsonPointers_;
+    mutable UrlEncodedIndex queryFields_;
+    mutable UrlEncodedIndex formFields_;
 };
 
 // Template implementation for body parsing
 template<typename T>
 T Request::getBody() const {
-    // Default implementation - can be specialized for different types
-    return T();
+    if constexpr (std::is_same_v<T, std::string>) {
+        return body;
+    } else if constexpr (isJsonSerializable<T>) {
+        return fromJson<T>(body);
+    } else {
+        // Default implementation - can be specialized for different types
+        return T();
+    }
 }
 
 } // namespace httpapi 
\ No newline at end of file
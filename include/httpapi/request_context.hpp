@@ -0,0 +1,161 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace httpapi {
+
+// Typed values that middleware hands on to later middleware and handlers,
+// e.g. the authenticated user or the resolved tenant. Every value type gets
+// a process-wide slot index the first time it is named (call key<T>() at
+// startup to fix it early), and each request holds one slot per index, so
+// an access is an array lookup with the type checked at compile time.
+// Values up to a few hundred bytes in total live in a buffer inside the
+// context; only larger ones are heap-allocated.
+//
+//     struct AuthInfo { std::string user; bool admin = false; };
+//
+//     app.use([](Request& req, Response& res, auto next) {
+//         req.ctx<AuthInfo>().user = verify(req.get("Authorization"));
+//         next();
+//     });
+//     app.get("/me", [](Request& req, Response& res) {
+//         res.send(req.ctx<AuthInfo>().user);
+//     });
+class RequestContext {
+public:
+    RequestContext() = default;
+    RequestContext(const RequestContext& other);
+    RequestContext(RequestContext&& other);
+    RequestContext& operator=(const RequestContext& other);
+    RequestContext& operator=(RequestContext&& other);
+    ~RequestContext();
+    
+    // Slot index for T, assigned once per process
+    template<typename T>
+    static size_t key() {
+        static const size_t index = nextKey();
+        return index;
+    }
+    
+    // The stored T, default-constructed on first access
+    template<typename T>
+    T& get() {
+        if (T* value = find<T>()) {
+            return *value;
+        }
+        return emplace<T>();
+    }
+    
+    // Store a new T, replacing any previous one
+    template<typename T, typename... Args>
+    T& emplace(Args&&... args) {
+        return emplaceAt<T>(key<T>(), std::forward<Args>(args)...);
+    }
+    
+    // The stored T, or nullptr
+    template<typename T>
+    T* find() {
+        const Slot* slot = slotAt(key<T>());
+        return slot && slot->value ? static_cast<T*>(slot->value) : nullptr;
+    }
+    
+    template<typename T>
+    const T* find() const {
+        const Slot* slot = slotAt(key<T>());
+        return slot && slot->value ? static_cast<const T*>(slot->value) : nullptr;
+    }
+    
+    template<typename T>
+    bool has() const { return find<T>() != nullptr; }
+    
+    template<typename T>
+    void erase() {
+        if (Slot* slot = mutableSlotAt(key<T>())) {
+            reset(*slot);
+        }
+    }
+    
+    void clear();
+    
+private:
+    static constexpr size_t kInlineSlots = 16;
+    static constexpr size_t kInlineBytes = 256;
+    
+    // Type-erased operations for one stored type
+    struct Ops {
+        void (*destroy)(void* value);
+        void (*copy)(const void* value, RequestContext& to, size_t index);
+        void (*move)(void* value, RequestContext& to, size_t index);
+    };
+    
+    struct Slot {
+        void* value = nullptr;
+        const Ops* ops = nullptr;
+        bool heap = false;
+    };
+    
+    static size_t nextKey();
+    
+    template<typename T>
+    static const Ops* opsFor() {
+        static const Ops ops = {
+            [](void* value) { static_cast<T*>(value)->~T(); },
+            [](const void* value, RequestContext& to, size_t index) {
+                if constexpr (std::is_copy_constructible_v<T>) {
+                    to.emplaceAt<T>(index, *static_cast<const T*>(value));
+                } else {
+                    throw std::logic_error("RequestContext: stored value is not copyable");
+                }
+            },
+            [](void* value, RequestContext& to, size_t index) {
+                to.emplaceAt<T>(index, std::move(*static_cast<T*>(value)));
+            }
+        };
+        return &ops;
+    }
+    
+    template<typename T, typename... Args>
+    T& emplaceAt(size_t index, Args&&... args) {
+        static_assert(std::is_same_v<T, std::decay_t<T>>, "RequestContext stores plain value types");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not supported");
+        bool heap = false;
+        void* memory = allocate(sizeof(T), alignof(T), heap);
+        T* value;
+        try {
+            value = new (memory) T(std::forward<Args>(args)...);
+        } catch (...) {
+            if (heap) {
+                ::operator delete(memory);
+            }
+            throw;
+        }
+        // The old value goes only now, in case it was an argument
+        Slot& slot = slotFor(index);
+        reset(slot);
+        slot.value = value;
+        slot.ops = opsFor<T>();
+        slot.heap = heap;
+        return *value;
+    }
+    
+    const Slot* slotAt(size_t index) const;
+    Slot* mutableSlotAt(size_t index);
+    Slot& slotFor(size_t index);
+    void* allocate(size_t size, size_t alignment, bool& heap);
+    void reset(Slot& slot);
+    void copyFrom(const RequestContext& other);
+    void moveFrom(RequestContext& other);
+    
+    std::array<Slot, kInlineSlots> slots_;
+    std::vector<Slot> overflow_; // slots from index kInlineSlots on
+    alignas(std::max_align_t) unsigned char buffer_[kInlineBytes];
+    size_t used_ = 0;
+};
+
+} // namespace httpapi 
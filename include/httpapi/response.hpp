@@ -4,9 +4,33 @@
 #include <unordered_map>
 #include <functional>
 #include <memory>
+#include <string_view>
+#include <type_traits>
+#include <iterator>
+#include <utility>
+#include "file_region.hpp"
+#include "headers.hpp"
+#include "json_binding.hpp"
 
 namespace httpapi {
 
+namespace detail {
+
+template<typename Range, typename = void>
+struct IsJsonRowRange : std::false_type {};
+
+template<typename Range>
+struct IsJsonRowRange<Range, std::void_t<decltype(std::begin(std::declval<std::decay_t<Range>&>())),
+                                          decltype(std::end(std::declval<std::decay_t<Range>&>()))>>
+    : std::bool_constant<isJsonSerializable<std::decay_t<decltype(*std::begin(std::declval<std::decay_t<Range>&>()))>> &&
+                         !std::is_convertible_v<const std::decay_t<Range>&, std::string>> {};
+
+// A container or other range whose elements can each be written as JSON
+template<typename Range>
+constexpr bool isJsonRowRange = IsJsonRowRange<Range>::value;
+
+} // namespace detail
+
 class Response {
 public:
     Response();
@@ -15,8 +39,8 @@ public:
     int statusCode;
     std::string statusMessage;
     
-    // Headers
-    std::unordered_map<std::string, std::string> headers;
+    // Headers, written in the order they were first set
+    Headers headers;
     
     // Body
     std::string body;
@@ -25,11 +49,79 @@ public:
     Response& status(int code);
     Response& set(const std::string& field, const std::string& value);
     Response& header(const std::string& field, const std::string& value);
+    // Add another value without replacing existing ones, e.g. Set-Cookie
+    Response& append(const std::string& field, const std::string& value);
+    std::string get(const std::string& field) const;
     
     // Sending responses
     Response& send(const std::string& data);
     Response& json(const std::string& data);
+    
+    // Serialize straight into `body` without an intermediate string:
+    //     res.json([&](JsonWriter& w) { w.beginObject().member("id", id).endObject(); });
+    template<typename Build, std::enable_if_t<std::is_invocable_v<Build&, JsonWriter&>, int> = 0>
+    Response& json(Build&& build) {
+        JsonWriter writer(beginJson());
+        build(writer);
+        return endJson();
+    }
+    
+    // Encode a JSON-bound struct (see HTTPAPI_JSON_FIELDS) or a container of
+    // them straight into `body`
+    template<typename T, std::enable_if_t<isJsonSerializable<T> &&
+                                          !std::is_convertible_v<const T&, std::string>, int> = 0>
+    Response& json(const T& value) {
+        toJson(value, beginJson());
+        return endJson();
+    }
     Response& sendFile(const std::string& path);
+    
+    // Send part of a mapped file without copying it; `body` stays empty and
+    // the region is kept alive until the response is destroyed or cleared
+    Response& send(std::shared_ptr<const FileRegion> region, size_t offset = 0,
+                   size_t length = std::string::npos);
+    
+    // The bytes to send: the mapped region if one is attached, else `body`
+    std::string_view bodyView() const;
+    
+    // Streamed bodies. The producer appends the next piece of the body to
+    // `out` and returns false once that piece is the last; the server sends
+    // each piece as soon as it is produced, with chunked transfer encoding,
+    // so nothing beyond one piece is held in memory. The producer runs after
+    // the handler has returned and must not refer to its locals.
+    using StreamProducer = std::function<bool(std::string& out)>;
+    Response& stream(StreamProducer producer);
+    bool isStreaming() const { return static_cast<bool>(producer_); }
+    StreamProducer& streamProducer() { return producer_; }
+    
+    // Producers built here hand the server pieces of about this size
+    static constexpr size_t kStreamChunkSize = 16 * 1024;
+    
+    // Row generators write one row and return true, or return false without
+    // writing anything once there are no more rows:
+    //     res.ndjson([cursor](JsonWriter& w) {
+    //         if (!cursor->next()) return false;
+    //         w.beginObject().member("id", cursor->id()).endObject();
+    //         return true;
+    //     });
+    using RowGenerator = std::function<bool(JsonWriter&)>;
+    
+    // One row per line (application/x-ndjson)
+    Response& ndjson(RowGenerator rows);
+    // A single JSON array whose elements are the rows
+    Response& jsonArray(RowGenerator rows);
+    
+    // The same for a range of JSON-serializable values; the range is moved
+    // (or copied) into the response since rows are written after the
+    // handler returns
+    template<typename Range, std::enable_if_t<detail::isJsonRowRange<Range>, int> = 0>
+    Response& ndjson(Range&& rows) {
+        return ndjson(rowsOf(std::forward<Range>(rows)));
+    }
+    template<typename Range, std::enable_if_t<detail::isJsonRowRange<Range>, int> = 0>
+    Response& jsonArray(Range&& rows) {
+        return jsonArray(rowsOf(std::forward<Range>(rows)));
+    }
     Response& redirect(const std::string& url);
     
     // Status helpers
@@ -44,6 +136,7 @@ public:
     
     // Utility methods
     std::string toString() const;
+    std::string headerString() const;
     void clear();
     
     // Internal use
@@ -51,8 +144,38 @@ public:
     std::string getStatusText(int code) const;
     
 private:
+    std::string& beginJson();
+    Response& endJson();
+    void dropStream();
+    
+    template<typename Range>
+    static RowGenerator rowsOf(Range&& rows) {
+        using Stored = std::decay_t<Range>;
+        struct State {
+            Stored range;
+            decltype(std::begin(std::declval<Stored&>())) next;
+            bool started;
+        };
+        auto state = std::make_shared<State>(State{std::forward<Range>(rows), {}, false});
+        return [state](JsonWriter& writer) {
+            if (!state->started) {
+                state->next = std::begin(state->range);
+                state->started = true;
+            }
+            if (state->next == std::end(state->range)) {
+                return false;
+            }
+            JsonCodec<std::decay_t<decltype(*state->next)>>::write(writer, *state->next);
+            ++state->next;
+            return true;
+        };
+    }
+    
     bool headersSent_;
     bool ended_;
+    std::shared_ptr<const FileRegion> region_;
+    std::string_view regionView_;
+    StreamProducer producer_;
 };
 
 } // namespace httpapi 
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+
+#include "middleware.hpp"
+
+namespace httpapi {
+
+struct ResponseCacheOptions {
+    // Lifetime for responses that do not state max-age/s-maxage
+    std::chrono::seconds ttl{60};
+    
+    // Total byte budget across all shards
+    size_t maxBytes = 64 * 1024 * 1024;
+    
+    // Independent LRU partitions, each with its own lock
+    size_t shards = 16;
+    
+    // Key on the whole query string, or only on queryKeys when that is non-empty
+    bool includeQuery = true;
+    std::vector<std::string> queryKeys;
+    
+    // Request headers that always form part of the key. Responses to requests
+    // carrying Authorization are only stored when it is listed here or the
+    // response is marked public, s-maxage or must-revalidate.
+    std::vector<std::string> keyHeaders;
+};
+
+struct ResponseCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t stores = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+    
+    double hitRate() const {
+        uint64_t lookups = hits + misses;
+        return lookups ? static_cast<double>(hits) / lookups : 0.0;
+    }
+};
+
+// Caches complete GET/HEAD responses in memory. Copies of a ResponseCache
+// share the same storage, so one handle can be kept for stats and another
+// registered as middleware.
+class ResponseCache {
+public:
+    explicit ResponseCache(ResponseCacheOptions options = ResponseCacheOptions());
+    
+    Middleware::MiddlewareFunction middleware() const;
+    
+    ResponseCacheStats stats() const;
+    void clear();
+    
+private:
+    struct Impl;
+    std::shared_ptr<Impl> impl_;
+};
+
+} // namespace httpapi 
@@ -6,9 +6,13 @@
 #include <vector>
 #include <regex>
 #include <memory>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
 
 #include "request.hpp"
 #include "response.hpp"
+#include "middleware.hpp"
 
 namespace httpapi {
 
@@ -19,6 +23,7 @@ struct Route {
     std::regex regex;
     std::vector<std::string> paramNames;
     std::function<void(Request&, Response&)> handler;
+    Middleware::Chain middlewareChain;
     
     Route(const std::string& method, const std::string& path, 
           std::function<void(Request&, Response&)> handler);
@@ -30,31 +35,88 @@ struct Route {
     static std::string pathToRegex(const std::string& path, std::vector<std::string>& paramNames);
 };
 
+// Immutable snapshot of the registered routes. Writers build a new table and
+// publish it; readers never see a table being modified.
+struct RouteTable {
+    uint64_t version = 0;
+    const Middleware* middleware = nullptr;
+    std::vector<std::shared_ptr<const Route>> routes;
+};
+
 class Router {
 public:
     Router();
     ~Router();
     
-    // Route registration
+    Router(const Router&) = delete;
+    Router& operator=(const Router&) = delete;
+    
+    // Route registration (safe to call while the server is running)
     void get(const std::string& path, std::function<void(Request&, Response&)> handler);
     void post(const std::string& path, std::function<void(Request&, Response&)> handler);
     void put(const std::string& path, std::function<void(Request&, Response&)> handler);
     void delete_(const std::string& path, std::function<void(Request&, Response&)> handler);
     void patch(const std::string& path, std::function<void(Request&, Response&)> handler);
     
+    // Remove a route registered with the same method and path
+    bool remove(const std::string& method, const std::string& path);
+    
+    // Precompile each route's middleware chain; the middleware must outlive
+    // the router and must not change afterwards
+    void setMiddleware(const Middleware* middleware);
+    
     // Route matching
     bool handleRequest(Request& req, Response& res);
     
+    // Run the matched route's middleware and handler, or all path-matching
+    // middleware followed by notFound when no route matches. If middleware
+    // calls req.rewrite(), the handler (or notFound) is chosen again for the
+    // rewritten request.
+    void dispatch(Request& req, Response& res,
+                  const std::function<void(Request&, Response&)>& notFound);
+    
     // Utility methods
     void clear();
     size_t getRouteCount() const;
+    uint64_t getVersion() const;
     
 private:
-    std::vector<std::unique_ptr<Route>> routes_;
+    // Marks the calling thread as reading the current table until destroyed
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const Router& router);
+        ~ReadGuard();
+        
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        
+        const RouteTable& table() const { return *table_; }
+        
+    private:
+        const Router& router_;
+        unsigned slot_;
+        const RouteTable* table_;
+    };
+    
+    struct alignas(64) ReaderCount {
+        std::atomic<size_t> value{0};
+    };
+    
+    std::atomic<const RouteTable*> table_;
+    std::atomic<unsigned> epoch_;
+    mutable ReaderCount readers_[2];
+    std::mutex writeMutex_;
     
     // Helper methods
+    void addRoute(const std::string& method, const std::string& path,
+                  std::function<void(Request&, Response&)> handler);
+    bool runRoute(Request& req, Response& res,
+                  const std::function<void(Request&, Response&)>& notFound);
+    std::shared_ptr<const Route> findRoute(const Request& req, const Middleware** middleware) const;
+    void publish(std::unique_ptr<RouteTable> next);
+    void synchronize();
     std::string pathToRegex(const std::string& path, std::vector<std::string>& paramNames);
     std::string escapeRegex(const std::string& str);
 };
 
-} // namespace httpapi 
\ No newline at end of file
+} // namespace httpapi 
@@ -4,16 +4,83 @@
 #include <unordered_map>
 #include <fstream>
 #include <sstream>
+#include <ctime>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+#include <mutex>
+
+#include "request.hpp"
+#include "response.hpp"
+#include "file_watcher.hpp"
+#include "compression.hpp"
+#include "file_region.hpp"
 
 namespace httpapi {
 
+// Per-mount caching behaviour for static files
+struct StaticFileOptions {
+    // Cache-Control value sent with every file from the mount (empty = none)
+    std::string cacheControl;
+    
+    // Validators used for conditional GET (If-None-Match / If-Modified-Since)
+    bool etag = true;
+    bool lastModified = true;
+    
+    // Keep small files in memory; only effective while the mount can be watched
+    bool memoryCache = true;
+    
+    // Walk the directory at start() into a URL path -> file index, so lookups
+    // and misses under the mount are a single hash probe. The index follows
+    // changes while the mount is watched.
+    bool preindex = false;
+    
+    // Serve app.js.br / app.js.zst / app.js.gz in place of app.js when the
+    // client accepts that encoding. Needs the mount to be watched (or
+    // preindexed), since the siblings found are remembered per file.
+    bool precompressed = true;
+    
+    // Files at least this large are memory-mapped instead of read, and one
+    // mapping is shared by all concurrent downloads of the file (0 = never map)
+    uint64_t mmapThreshold = 1024 * 1024;
+    
+    // Hash every file at start() and also serve it as name.<hash>.ext with a
+    // one-year immutable Cache-Control; see StaticFileHandler::assetUrl().
+    // Implies preindex.
+    bool fingerprint = false;
+};
+
 class StaticFileHandler {
 public:
     StaticFileHandler();
     ~StaticFileHandler();
     
+    StaticFileHandler(const StaticFileHandler&) = delete;
+    StaticFileHandler& operator=(const StaticFileHandler&) = delete;
+    
     // Configure static file serving
-    void setStaticPath(const std::string& urlPath, const std::string& filePath);
+    void setStaticPath(const std::string& urlPath, const std::string& filePath,
+                       const StaticFileOptions& options = StaticFileOptions());
+    
+    // Memory cache budget; files above maxFileSize are always read from disk
+    void setCacheLimits(size_t maxBytes, size_t maxFileSize);
+    
+    // Watch the mounts so cached files are dropped as soon as they change.
+    // Call after all mounts are configured and before serving.
+    void start();
+    void stop();
+    
+    // Serve a request, answering conditional requests with 304 Not Modified
+    // and Range requests with 206 Partial Content (or 416).
+    // Returns false when no file matches so the request can fall through.
+    bool serve(const Request& req, Response& res);
+    
+    // Fingerprinted URL for a file under a fingerprint mount
+    // ("/static/app.js" -> "/static/app.3f2a9c1b7d4e.js"), or urlPath
+    // unchanged if it has none
+    std::string assetUrl(const std::string& urlPath) const;
     
     // Serve static file
     bool serveFile(const std::string& requestPath, std::string& content, 
@@ -32,11 +99,105 @@ public:
     static bool readFile(const std::string& path, std::string& content);
     
 private:
-    std::unordered_map<std::string, std::string> staticPaths_;
+    struct Mount {
+        std::string directory;
+        std::string root; // canonical directory, empty if it does not exist
+        StaticFileOptions options;
+        bool watched = false;
+        bool indexed = false;
+    };
+    
+    struct FileInfo {
+        uint64_t size = 0;
+        std::time_t modified = 0;
+        
+        bool operator==(const FileInfo& other) const {
+            return size == other.size && modified == other.modified;
+        }
+    };
+    
+    // Inclusive byte range of a Range request, already clamped to the file
+    struct ByteRange {
+        uint64_t first;
+        uint64_t last;
+    };
+    
+    // A live mapping, reused while any response still holds it
+    struct MappedFile {
+        FileInfo info;
+        std::weak_ptr<const FileRegion> region;
+    };
+    
+    // Everything needed to answer a request for one file, with its headers
+    // already formatted
+    struct StaticFile {
+        std::string filePath;
+        FileInfo info;
+        std::string contentType;
+        std::string etag;
+        std::string lastModified;
+        std::string cacheControl;
+        std::string contentEncoding; // set on precompressed variants
+        std::vector<std::shared_ptr<const StaticFile>> variants;
+        std::shared_ptr<const std::string> content;
+        mutable std::atomic<uint64_t> lastUsed{0};
+        
+        std::shared_ptr<StaticFile> describe() const;
+    };
+    
+    std::unordered_map<std::string, Mount> staticPaths_;
+    
+    // Memory cache keyed by request path
+    mutable std::shared_mutex cacheMutex_;
+    std::unordered_map<std::string, std::shared_ptr<const StaticFile>> cache_;
+    
+    // Metadata of every file under preindexed mounts, keyed by request path
+    std::unordered_map<std::string, std::shared_ptr<const StaticFile>> index_;
+    
+    // Metadata, without content, of files served from other watched mounts,
+    // keyed by request path
+    std::unordered_map<std::string, std::shared_ptr<const StaticFile>> described_;
+    size_t cacheBytes_;
+    size_t maxCacheBytes_;
+    size_t maxCachedFileSize_;
+    std::atomic<uint64_t> generation_;
+    std::atomic<uint64_t> useClock_;
+    std::vector<std::unique_ptr<FileWatcher>> watchers_;
+    
+    // Request path -> fingerprinted request path, for fingerprint mounts
+    std::unordered_map<std::string, std::string> assets_;
+    
+    // Mappings of large files keyed by file path
+    std::mutex regionMutex_;
+    std::unordered_map<std::string, MappedFile> regions_;
     
     // Helper methods
-    std::string resolvePath(const std::string& requestPath);
+    std::string resolvePath(const std::string& requestPath, const Mount** mount = nullptr);
+    const Mount* findMount(const std::string& requestPath) const;
+    static std::shared_ptr<StaticFile> describeFile(const std::string& path, const FileInfo& info,
+                                                    const Mount& mount, bool probeSiblings);
+    void indexMount(const std::string& urlPath, const Mount& mount, const std::string& changedPath);
     bool isPathSafe(const std::string& path);
+    static bool isPathSafe(const std::string& path, const Mount& mount);
+    static bool statFile(const std::string& path, FileInfo& info);
+    static std::string makeETag(const FileInfo& info);
+    static bool hashFile(const std::string& path, std::string& hash);
+    static std::string fingerprintUrl(const std::string& urlPath, const std::string& hash);
+    static std::shared_ptr<StaticFile> makeImmutable(const StaticFile& file);
+    static bool isNotModified(const Request& req, const StaticFile& file);
+    static void respond(Response& res, const StaticFile& file, bool notModified,
+                        std::shared_ptr<const FileRegion> region = nullptr);
+    static void setFileHeaders(Response& res, const StaticFile& file);
+    static bool wantsRange(const Request& req, const StaticFile& file, std::vector<ByteRange>& ranges);
+    static bool parseRange(const std::string& header, uint64_t size, std::vector<ByteRange>& ranges);
+    static bool respondPartial(Response& res, const StaticFile& file, const std::vector<ByteRange>& ranges,
+                               const std::string* content, std::shared_ptr<const FileRegion> region);
+    static bool readRange(const std::string& path, const ByteRange& range, std::string& out);
+    std::shared_ptr<const FileRegion> mapFile(const StaticFile& file);
+    void insertCached(const std::string& key, std::shared_ptr<const StaticFile> file, uint64_t generation);
+    void insertDescribed(const std::string& key, std::shared_ptr<const StaticFile> file, uint64_t generation);
+    void invalidate(const std::string& changedPath);
+    void invalidatePath(const std::string& changedPath);
 };
 
-} // namespace httpapi 
\ No newline at end of file
+} // namespace httpapi 
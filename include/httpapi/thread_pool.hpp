@@ -0,0 +1,45 @@
+#pragma once
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <cstddef>
+
+namespace httpapi {
+
+// Fixed set of worker threads running queued tasks in FIFO order. Used for
+// CPU-bound work that can be split up, such as serializing large JSON
+// arrays; request handling itself does not go through it.
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+    
+    // 0 picks std::thread::hardware_concurrency()
+    explicit ThreadPool(size_t threads = 0);
+    // Runs the tasks still queued, then joins the workers
+    ~ThreadPool();
+    
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    // Tasks must not throw
+    void submit(Task task);
+    size_t size() const { return workers_.size(); }
+    
+    // Process-wide pool with one thread per core, started on first use
+    static ThreadPool& shared();
+    
+private:
+    void run();
+    
+    std::vector<std::thread> workers_;
+    std::deque<Task> tasks_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    bool stopping_;
+};
+
+} // namespace httpapi 
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace httpapi {
+
+// Fields of an application/x-www-form-urlencoded text (a query string or a
+// form body), split on the first lookup rather than up front. Keys and
+// values are kept as offsets into the text and percent-decoded only when
+// they contain '%' or '+': keys while splitting, values on first access.
+// Keys may repeat; a field without '=' has an empty value.
+//
+// Returned views point into the text or into the index, and stay valid
+// until the text changes or the index is cleared. The index does not watch
+// the text: its owner calls clear() whenever the text changes.
+class UrlEncodedIndex {
+public:
+    // First value for `name`. The index is built on the first call after
+    // clear(), and also rebuilt when `text` has a different length, so stale
+    // offsets can never reach past its end.
+    std::optional<std::string_view> find(std::string_view text, std::string_view name);
+    
+    // Every value for `name`, in order
+    std::vector<std::string_view> findAll(std::string_view text, std::string_view name);
+    
+    void clear();
+    
+    // Append `text` with %XX escapes decoded and '+' as a space; malformed
+    // escapes are kept as they are
+    static void decode(std::string_view text, std::string& out);
+    
+private:
+    struct Field {
+        size_t keyOffset;
+        size_t keyLength;
+        size_t valueOffset;
+        size_t valueLength;
+        bool keyEscaped;
+        bool valueEscaped;
+        bool valueDecoded;
+        std::string key;   // decoded, when keyEscaped
+        std::string value; // decoded on first access, when valueEscaped
+    };
+    
+    void index(std::string_view text);
+    std::string_view keyOf(std::string_view text, const Field& field) const;
+    std::string_view valueOf(std::string_view text, Field& field);
+    
+    size_t size_ = 0; // length of the indexed text
+    std::vector<Field> fields_;
+    bool indexed_ = false;
+};
+
+} // namespace httpapi 
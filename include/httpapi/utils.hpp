@@ -6,6 +6,8 @@
 #include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <ctime>
+#include "headers.hpp"
 
 namespace httpapi {
 
@@ -30,12 +32,16 @@ public:
     
     // Header utilities
     static std::string normalizeHeaderName(const std::string& name);
-    static std::unordered_map<std::string, std::string> parseHeaders(const std::string& headerText);
+    static Headers parseHeaders(const std::string& headerText);
     
     // Time utilities
     static std::string getCurrentTime();
     static std::string formatTime(const std::string& format);
     
+    // HTTP dates (IMF-fixdate, e.g. "Sun, 06 Nov 1994 08:49:37 GMT")
+    static std::string formatHttpDate(std::time_t time);
+    static bool parseHttpDate(const std::string& date, std::time_t& time);
+    
     // File utilities
     static std::string getFileSize(const std::string& path);
     static std::string getFileExtension(const std::string& filename);
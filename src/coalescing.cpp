@@ -0,0 +1,168 @@
+#include "httpapi/coalescing.hpp"
+#include "httpapi/utils.hpp"
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace httpapi {
+
+namespace {
+
+struct Flight {
+    std::mutex mutex;
+    std::condition_variable done;
+    bool finished = false;
+    
+    int statusCode = 200;
+    std::string statusMessage;
+    Headers headers;
+    std::string body;
+    bool shared = false; // false when waiters must run the handler themselves
+    std::exception_ptr error;
+};
+
+bool hasDirective(const std::string& cacheControl, const std::string& directive) {
+    for (const auto& item : Utils::split(cacheControl, ',')) {
+        std::string token = Utils::toLowerCase(Utils::trim(item));
+        if (token.substr(0, token.find('=')) == directive) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A streamed body was never materialized, and a response that sets a
+// cookie or is marked private belongs to the caller that produced it
+bool shareable(const Response& res) {
+    if (res.isStreaming() || res.headers.has(HeaderId::SetCookie)) {
+        return false;
+    }
+    std::string cacheControl = res.headers.get(HeaderId::CacheControl);
+    return !hasDirective(cacheControl, "private") && !hasDirective(cacheControl, "no-store");
+}
+
+struct FlightTable {
+    CoalescingOptions options;
+    RequestCoalescer::RequestHandler handler;
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<Flight>> flights;
+    
+    std::string key(const Request& req) const {
+        std::string key = req.method + ' ' + req.path;
+        if (!options.queryKeys.empty()) {
+            for (const auto& name : options.queryKeys) {
+                key += '\n' + name + '=' + req.query(name);
+            }
+        } else if (options.includeQuery) {
+            key += '?' + req.queryString;
+        }
+        for (const auto& name : options.keyHeaders) {
+            key += '\n' + name + ':' + req.get(name);
+        }
+        return key;
+    }
+    
+    bool keysOn(std::string_view header) const {
+        for (const auto& name : options.keyHeaders) {
+            if (Headers::equalsIgnoreCase(name, header)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    void run(Request& req, Response& res);
+};
+
+void FlightTable::run(Request& req, Response& res) {
+    if (req.method != "GET" && req.method != "HEAD") {
+        handler(req, res);
+        return;
+    }
+    // Credentials that are not part of the key could make one caller's
+    // response reach another
+    if ((req.headers.has(HeaderId::Authorization) && !keysOn("Authorization")) ||
+        (req.headers.has(HeaderId::Cookie) && !keysOn("Cookie"))) {
+        handler(req, res);
+        return;
+    }
+    
+    std::string flightKey = key(req);
+    std::shared_ptr<Flight> flight;
+    bool leader = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& slot = flights[flightKey];
+        if (!slot) {
+            slot = std::make_shared<Flight>();
+            leader = true;
+        }
+        flight = slot;
+    }
+    
+    if (!leader) {
+        std::unique_lock<std::mutex> lock(flight->mutex);
+        flight->done.wait(lock, [&flight]() { return flight->finished; });
+        if (flight->error) {
+            std::rethrow_exception(flight->error);
+        }
+        if (!flight->shared) {
+            lock.unlock();
+            handler(req, res);
+            return;
+        }
+        
+        res.statusCode = flight->statusCode;
+        res.statusMessage = flight->statusMessage;
+        res.headers.merge(flight->headers);
+        res.body = flight->body;
+        return;
+    }
+    
+    std::exception_ptr error;
+    try {
+        handler(req, res);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    
+    // Retire the flight before publishing so requests arriving from now on
+    // start a fresh run instead of receiving a completed result
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        flights.erase(flightKey);
+    }
+    {
+        std::lock_guard<std::mutex> lock(flight->mutex);
+        flight->shared = !error && shareable(res);
+        if (flight->shared) {
+            flight->statusCode = res.statusCode;
+            flight->statusMessage = res.statusMessage;
+            flight->headers = res.headers;
+            // A region-backed body (send(region)) is copied out; `body` is empty
+            flight->body = std::string(res.bodyView());
+        }
+        flight->error = error;
+        flight->finished = true;
+    }
+    flight->done.notify_all();
+    
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace
+
+RequestCoalescer::RequestHandler RequestCoalescer::wrap(RequestHandler handler, CoalescingOptions options) {
+    auto table = std::make_shared<FlightTable>();
+    table->options = std::move(options);
+    table->handler = std::move(handler);
+    return [table](Request& req, Response& res) {
+        table->run(req, res);
+    };
+}
+
+} // namespace httpapi 
@@ -0,0 +1,549 @@
+#include "httpapi/compression.hpp"
+#include "httpapi/utils.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+#ifdef HTTPAPI_HAS_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HTTPAPI_HAS_BROTLI
+#include <brotli/encode.h>
+#endif
+#ifdef HTTPAPI_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace httpapi {
+
+namespace {
+
+const size_t kOutputChunk = 16 * 1024;
+
+enum class FlushMode {
+    None,
+    Flush,
+    Finish
+};
+
+// LRU map of compressed variants of immutable bodies, bounded by total bytes
+class CompressedCache {
+public:
+    explicit CompressedCache(size_t capacity) : capacity_(capacity), size_(0) {}
+    
+    std::shared_ptr<const std::string> find(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return nullptr;
+        }
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->second;
+    }
+    
+    void insert(const std::string& key, std::shared_ptr<const std::string> value) {
+        size_t cost = key.size() + value->size();
+        if (cost > capacity_) {
+            return;
+        }
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (index_.count(key)) {
+            return;
+        }
+        entries_.emplace_front(key, std::move(value));
+        index_[key] = entries_.begin();
+        size_ += cost;
+        
+        while (size_ > capacity_) {
+            auto& last = entries_.back();
+            size_ -= last.first.size() + last.second->size();
+            index_.erase(last.first);
+            entries_.pop_back();
+        }
+    }
+    
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<const std::string>>;
+    
+    std::mutex mutex_;
+    std::list<Entry> entries_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    size_t capacity_;
+    size_t size_;
+};
+
+struct CompressionState {
+    CompressionOptions options;
+    CompressedCache cache;
+    
+    explicit CompressionState(CompressionOptions opts)
+        : options(std::move(opts)), cache(options.cacheBytes) {}
+    
+    void apply(const Request& req, Response& res);
+};
+
+uint64_t fnv1a(std::string_view data) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Whether a comma-separated header (Cache-Control, Vary) lists `token`,
+// ignoring case, whitespace and any "=value" or ";param" part
+bool containsToken(std::string_view list, std::string_view token) {
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t end = list.find(',', pos);
+        if (end == std::string_view::npos) {
+            end = list.size();
+        }
+        std::string_view item = list.substr(pos, end - pos);
+        item = item.substr(0, item.find_first_of("=;"));
+        while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) {
+            item.remove_prefix(1);
+        }
+        while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) {
+            item.remove_suffix(1);
+        }
+        if (Headers::equalsIgnoreCase(item, token)) {
+            return true;
+        }
+        pos = end + 1;
+    }
+    return false;
+}
+
+void CompressionState::apply(const Request& req, Response& res) {
+    if (res.statusCode < 200 || res.statusCode == 204 || res.statusCode == 304) {
+        return;
+    }
+    // Content-Range offsets describe the identity bytes
+    if (res.statusCode == 206 || res.headers.has(HeaderId::ContentRange)) {
+        return;
+    }
+    if (!res.get("Content-Encoding").empty() ||
+        !Compression::isCompressible(res.get("Content-Type"), options.types)) {
+        return;
+    }
+    
+    std::string cacheControl = res.get("Cache-Control");
+    if (containsToken(cacheControl, "no-transform")) {
+        return;
+    }
+    
+    // The representation depends on Accept-Encoding even when we end up
+    // sending it uncompressed
+    std::string vary = res.get("Vary");
+    if (vary.empty()) {
+        res.set("Vary", "Accept-Encoding");
+    } else if (!containsToken(vary, "accept-encoding")) {
+        res.set("Vary", vary + ", Accept-Encoding");
+    }
+    
+    // A streamed body has no size up front, so the threshold cannot apply.
+    // A file region sent with send(region) has an empty `body`; its bytes
+    // are only reachable through bodyView().
+    std::string_view body = res.bodyView();
+    if (!res.isStreaming() && body.size() < options.threshold) {
+        return;
+    }
+    
+    ContentEncoding encoding = Compression::negotiate(req.get("Accept-Encoding"));
+    if (encoding == ContentEncoding::Identity) {
+        return;
+    }
+    std::string name = Compression::encodingName(encoding);
+    
+    if (res.isStreaming()) {
+        // Compress each piece as it goes out and flush it, so the client can
+        // decode rows as they arrive; streamed bodies are never cached
+        auto compressor = std::make_shared<Compressor>(encoding, options.level);
+        res.stream([inner = std::move(res.streamProducer()), compressor,
+                    piece = std::string()](std::string& out) mutable {
+            piece.clear();
+            bool more = inner(piece);
+            compressor->update(piece.data(), piece.size(), out);
+            if (more) {
+                compressor->flush(out);
+            } else {
+                compressor->finish(out);
+            }
+            return more;
+        });
+        res.set("Content-Encoding", name);
+        std::string etag = res.get("ETag");
+        if (!etag.empty() && etag[0] == '"') {
+            res.set("ETag", "W/" + etag);
+        }
+        return;
+    }
+    
+    // Only bodies that are guaranteed not to change under the same key are
+    // cached: those with an ETag, or explicitly marked immutable
+    std::string etag = res.get("ETag");
+    std::string key;
+    if (options.cacheBytes > 0) {
+        if (!etag.empty()) {
+            // An ETag is only unique within one URL
+            key = name + ":" + req.method + " " + req.path + "?" + req.queryString + ":" + etag + ":" +
+                  std::to_string(body.size());
+        } else if (containsToken(cacheControl, "immutable")) {
+            key = name + ":#" + std::to_string(fnv1a(body)) + ":" + std::to_string(body.size());
+        }
+    }
+    
+    std::shared_ptr<const std::string> compressed;
+    if (!key.empty()) {
+        compressed = cache.find(key);
+    }
+    if (!compressed) {
+        compressed = std::make_shared<const std::string>(
+            Compression::compress(body, encoding, options.level));
+        if (compressed->size() >= body.size()) {
+            return;
+        }
+        if (!key.empty()) {
+            cache.insert(key, compressed);
+        }
+    }
+    
+    // Also releases a file region, which would otherwise be sent instead
+    res.send(*compressed);
+    res.set("Content-Encoding", name);
+    res.set("Content-Length", std::to_string(res.body.size()));
+    
+    // The compressed bytes differ from the identity representation
+    if (!etag.empty() && etag[0] == '"') {
+        res.set("ETag", "W/" + etag);
+    }
+}
+
+} // namespace
+
+struct Compressor::Impl {
+#ifdef HTTPAPI_HAS_ZLIB
+    z_stream zlib{};
+    bool zlibActive = false;
+#endif
+#ifdef HTTPAPI_HAS_BROTLI
+    BrotliEncoderState* brotli = nullptr;
+#endif
+#ifdef HTTPAPI_HAS_ZSTD
+    ZSTD_CCtx* zstd = nullptr;
+#endif
+    
+    ~Impl() {
+#ifdef HTTPAPI_HAS_ZLIB
+        if (zlibActive) {
+            deflateEnd(&zlib);
+        }
+#endif
+#ifdef HTTPAPI_HAS_BROTLI
+        if (brotli) {
+            BrotliEncoderDestroyInstance(brotli);
+        }
+#endif
+#ifdef HTTPAPI_HAS_ZSTD
+        if (zstd) {
+            ZSTD_freeCCtx(zstd);
+        }
+#endif
+    }
+    
+    void run(ContentEncoding encoding, const char* data, size_t size, FlushMode mode, std::string& out);
+};
+
+void Compressor::Impl::run(ContentEncoding encoding, const char* data, size_t size,
+                           FlushMode mode, std::string& out) {
+    switch (encoding) {
+#ifdef HTTPAPI_HAS_ZLIB
+        case ContentEncoding::Gzip:
+        case ContentEncoding::Deflate: {
+            // avail_in is 32-bit; feed very large inputs in slices
+            do {
+                size_t slice = std::min(size, static_cast<size_t>(UINT_MAX / 2));
+                bool lastSlice = slice == size;
+                int flush = Z_NO_FLUSH;
+                if (lastSlice && mode == FlushMode::Flush) flush = Z_SYNC_FLUSH;
+                if (lastSlice && mode == FlushMode::Finish) flush = Z_FINISH;
+                
+                zlib.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+                zlib.avail_in = static_cast<uInt>(slice);
+                int ret;
+                do {
+                    size_t used = out.size();
+                    out.resize(used + kOutputChunk);
+                    zlib.next_out = reinterpret_cast<Bytef*>(&out[used]);
+                    zlib.avail_out = static_cast<uInt>(kOutputChunk);
+                    ret = deflate(&zlib, flush);
+                    out.resize(used + kOutputChunk - zlib.avail_out);
+                    if (ret == Z_STREAM_ERROR) {
+                        throw std::runtime_error("zlib compression failed");
+                    }
+                } while (zlib.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+                
+                data += slice;
+                size -= slice;
+            } while (size > 0);
+            break;
+        }
+#endif
+#ifdef HTTPAPI_HAS_BROTLI
+        case ContentEncoding::Brotli: {
+            BrotliEncoderOperation op = BROTLI_OPERATION_PROCESS;
+            if (mode == FlushMode::Flush) op = BROTLI_OPERATION_FLUSH;
+            if (mode == FlushMode::Finish) op = BROTLI_OPERATION_FINISH;
+            
+            size_t availIn = size;
+            const uint8_t* nextIn = reinterpret_cast<const uint8_t*>(data);
+            do {
+                size_t used = out.size();
+                out.resize(used + kOutputChunk);
+                size_t availOut = kOutputChunk;
+                uint8_t* nextOut = reinterpret_cast<uint8_t*>(&out[used]);
+                if (!BrotliEncoderCompressStream(brotli, op, &availIn, &nextIn,
+                                                 &availOut, &nextOut, nullptr)) {
+                    throw std::runtime_error("brotli compression failed");
+                }
+                out.resize(used + kOutputChunk - availOut);
+            } while (availIn > 0 || BrotliEncoderHasMoreOutput(brotli) ||
+                     (op == BROTLI_OPERATION_FINISH && !BrotliEncoderIsFinished(brotli)));
+            break;
+        }
+#endif
+#ifdef HTTPAPI_HAS_ZSTD
+        case ContentEncoding::Zstd: {
+            ZSTD_EndDirective directive = ZSTD_e_continue;
+            if (mode == FlushMode::Flush) directive = ZSTD_e_flush;
+            if (mode == FlushMode::Finish) directive = ZSTD_e_end;
+            
+            ZSTD_inBuffer input = {data, size, 0};
+            size_t remaining;
+            do {
+                size_t used = out.size();
+                out.resize(used + kOutputChunk);
+                ZSTD_outBuffer output = {&out[used], kOutputChunk, 0};
+                remaining = ZSTD_compressStream2(zstd, &output, &input, directive);
+                out.resize(used + output.pos);
+                if (ZSTD_isError(remaining)) {
+                    throw std::runtime_error("zstd compression failed");
+                }
+            } while (directive == ZSTD_e_continue ? input.pos < input.size : remaining != 0);
+            break;
+        }
+#endif
+        default:
+            (void)data;
+            (void)size;
+            (void)mode;
+            (void)out;
+            throw std::runtime_error("Unsupported content encoding");
+    }
+}
+
+Compressor::Compressor(ContentEncoding encoding, int level)
+    : encoding_(encoding), impl_(std::make_unique<Impl>()) {
+    if (!Compression::isAvailable(encoding) || encoding == ContentEncoding::Identity) {
+        throw std::runtime_error("Content encoding not available: " + Compression::encodingName(encoding));
+    }
+    
+    switch (encoding) {
+#ifdef HTTPAPI_HAS_ZLIB
+        case ContentEncoding::Gzip:
+        case ContentEncoding::Deflate: {
+            // windowBits + 16 selects the gzip wrapper; HTTP "deflate" is the zlib format
+            int windowBits = encoding == ContentEncoding::Gzip ? 15 + 16 : 15;
+            if (deflateInit2(&impl_->zlib, level < 0 ? Z_DEFAULT_COMPRESSION : level,
+                             Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                throw std::runtime_error("zlib initialization failed");
+            }
+            impl_->zlibActive = true;
+            break;
+        }
+#endif
+#ifdef HTTPAPI_HAS_BROTLI
+        case ContentEncoding::Brotli:
+            impl_->brotli = BrotliEncoderCreateInstance(nullptr, nullptr, nullptr);
+            if (!impl_->brotli) {
+                throw std::runtime_error("brotli initialization failed");
+            }
+            // Quality 11 is meant for offline use; 5 suits on-the-fly responses
+            BrotliEncoderSetParameter(impl_->brotli, BROTLI_PARAM_QUALITY,
+                                      static_cast<uint32_t>(level < 0 ? 5 : level));
+            break;
+#endif
+#ifdef HTTPAPI_HAS_ZSTD
+        case ContentEncoding::Zstd:
+            impl_->zstd = ZSTD_createCCtx();
+            if (!impl_->zstd) {
+                throw std::runtime_error("zstd initialization failed");
+            }
+            ZSTD_CCtx_setParameter(impl_->zstd, ZSTD_c_compressionLevel, level < 0 ? 3 : level);
+            break;
+#endif
+        default:
+            (void)level;
+            break;
+    }
+}
+
+Compressor::~Compressor() {
+}
+
+void Compressor::update(const char* data, size_t size, std::string& out) {
+    if (size > 0) {
+        impl_->run(encoding_, data, size, FlushMode::None, out);
+    }
+}
+
+void Compressor::flush(std::string& out) {
+    impl_->run(encoding_, nullptr, 0, FlushMode::Flush, out);
+}
+
+void Compressor::finish(std::string& out) {
+    impl_->run(encoding_, nullptr, 0, FlushMode::Finish, out);
+}
+
+bool Compression::isAvailable(ContentEncoding encoding) {
+    switch (encoding) {
+        case ContentEncoding::Identity:
+            return true;
+#ifdef HTTPAPI_HAS_ZLIB
+        case ContentEncoding::Gzip:
+        case ContentEncoding::Deflate:
+            return true;
+#endif
+#ifdef HTTPAPI_HAS_BROTLI
+        case ContentEncoding::Brotli:
+            return true;
+#endif
+#ifdef HTTPAPI_HAS_ZSTD
+        case ContentEncoding::Zstd:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+ContentEncoding Compression::negotiate(const std::string& acceptEncoding) {
+    static const std::vector<ContentEncoding> available = []() {
+        std::vector<ContentEncoding> encodings;
+        for (ContentEncoding encoding : {ContentEncoding::Brotli, ContentEncoding::Zstd,
+                                         ContentEncoding::Gzip, ContentEncoding::Deflate}) {
+            if (isAvailable(encoding)) {
+                encodings.push_back(encoding);
+            }
+        }
+        return encodings;
+    }();
+    return negotiate(acceptEncoding, available);
+}
+
+ContentEncoding Compression::negotiate(const std::string& acceptEncoding,
+                                       const std::vector<ContentEncoding>& candidates) {
+    if (candidates.empty() || acceptEncoding.empty()) {
+        return ContentEncoding::Identity;
+    }
+    
+    // Server preference when the client weighs several encodings equally
+    static const ContentEncoding preference[] = {
+        ContentEncoding::Brotli,
+        ContentEncoding::Zstd,
+        ContentEncoding::Gzip,
+        ContentEncoding::Deflate
+    };
+    
+    double weights[5] = {-1, -1, -1, -1, -1};
+    double wildcard = -1;
+    
+    for (const auto& item : Utils::split(acceptEncoding, ',')) {
+        size_t semicolon = item.find(';');
+        std::string coding = Utils::toLowerCase(Utils::trim(item.substr(0, semicolon)));
+        double q = 1.0;
+        if (semicolon != std::string::npos) {
+            std::string params = Utils::trim(item.substr(semicolon + 1));
+            if (params.compare(0, 2, "q=") == 0) {
+                try {
+                    q = std::stod(params.substr(2));
+                } catch (...) {
+                    q = 0;
+                }
+            }
+        }
+        
+        if (coding == "gzip" || coding == "x-gzip") {
+            weights[static_cast<int>(ContentEncoding::Gzip)] = q;
+        } else if (coding == "deflate") {
+            weights[static_cast<int>(ContentEncoding::Deflate)] = q;
+        } else if (coding == "br") {
+            weights[static_cast<int>(ContentEncoding::Brotli)] = q;
+        } else if (coding == "zstd") {
+            weights[static_cast<int>(ContentEncoding::Zstd)] = q;
+        } else if (coding == "*") {
+            wildcard = q;
+        }
+    }
+    
+    ContentEncoding best = ContentEncoding::Identity;
+    double bestWeight = 0;
+    for (ContentEncoding encoding : preference) {
+        double weight = weights[static_cast<int>(encoding)];
+        if (weight < 0) {
+            weight = wildcard;
+        }
+        bool offered = std::find(candidates.begin(), candidates.end(), encoding) != candidates.end();
+        if (weight > bestWeight && offered) {
+            best = encoding;
+            bestWeight = weight;
+        }
+    }
+    return best;
+}
+
+std::string Compression::encodingName(ContentEncoding encoding) {
+    switch (encoding) {
+        case ContentEncoding::Gzip: return "gzip";
+        case ContentEncoding::Deflate: return "deflate";
+        case ContentEncoding::Brotli: return "br";
+        case ContentEncoding::Zstd: return "zstd";
+        default: return "identity";
+    }
+}
+
+std::string Compression::compress(std::string_view data, ContentEncoding encoding, int level) {
+    Compressor compressor(encoding, level);
+    std::string out;
+    out.reserve(data.size() / 2 + 64);
+    compressor.update(data.data(), data.size(), out);
+    compressor.finish(out);
+    return out;
+}
+
+Middleware::MiddlewareFunction Compression::middleware(CompressionOptions options) {
+    auto state = std::make_shared<CompressionState>(std::move(options));
+    return [state](Request& req, Response& res, std::function<void()> next) {
+        next();
+        state->apply(req, res);
+    };
+}
+
+bool Compression::isCompressible(const std::string& contentType, const std::vector<std::string>& types) {
+    std::string type = Utils::toLowerCase(contentType);
+    for (const auto& prefix : types) {
+        if (type.compare(0, prefix.size(), prefix) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace httpapi 
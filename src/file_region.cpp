@@ -0,0 +1,111 @@
+#include "httpapi/file_region.hpp"
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace httpapi {
+
+FileRegion::FileRegion()
+    : data_(nullptr), size_(0) {
+#if defined(_WIN32)
+    mapping_ = nullptr;
+#endif
+}
+
+FileRegion::~FileRegion() {
+    if (!data_ || size_ == 0) {
+        return;
+    }
+#if defined(_WIN32)
+    UnmapViewOfFile(data_);
+    CloseHandle(mapping_);
+#else
+    munmap(const_cast<char*>(data_), size_);
+#endif
+}
+
+std::shared_ptr<const FileRegion> FileRegion::map(const std::string& path) {
+    std::shared_ptr<FileRegion> region(new FileRegion());
+    
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return nullptr;
+    }
+    if (size.QuadPart == 0) {
+        // Zero-length files cannot be mapped; an empty region is still valid
+        CloseHandle(file);
+        region->data_ = "";
+        return region;
+    }
+    
+    // The mapping keeps the file open, so the file handle can go now
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) {
+        return nullptr;
+    }
+    
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    
+    region->mapping_ = mapping;
+    region->data_ = static_cast<const char*>(data);
+    region->size_ = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return nullptr;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        region->data_ = "";
+        return region;
+    }
+    
+    // The mapping holds its own reference to the file
+    void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+    
+    // Responses read front to back: read ahead aggressively, drop pages behind
+    madvise(data, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+    
+    region->data_ = static_cast<const char*>(data);
+    region->size_ = static_cast<size_t>(st.st_size);
+#endif
+    
+    return region;
+}
+
+} // namespace httpapi 
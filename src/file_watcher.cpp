@@ -0,0 +1,245 @@
+#include "httpapi/file_watcher.hpp"
+#include <chrono>
+#include <filesystem>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace httpapi {
+
+FileWatcher::FileWatcher()
+    : running_(false), finished_(true) {
+#if defined(_WIN32)
+    directoryHandle_ = INVALID_HANDLE_VALUE;
+    threadHandle_ = nullptr;
+#elif defined(__linux__)
+    inotifyFd_ = -1;
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+    stop();
+}
+
+bool FileWatcher::isSupported() {
+#if defined(_WIN32) || defined(__linux__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool FileWatcher::isRunning() const {
+    return running_;
+}
+
+bool FileWatcher::start(const std::string& directory, Callback callback) {
+    if (running_) {
+        return false;
+    }
+    
+    try {
+        root_ = std::filesystem::canonical(directory).string();
+    } catch (...) {
+        return false;
+    }
+    callback_ = std::move(callback);
+    
+#if defined(_WIN32)
+    directoryHandle_ = CreateFileW(std::filesystem::path(root_).wstring().c_str(),
+                                   FILE_LIST_DIRECTORY,
+                                   FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                   nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (directoryHandle_ == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+#elif defined(__linux__)
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ < 0) {
+        return false;
+    }
+    addWatches(root_);
+    if (watches_.empty()) {
+        close(inotifyFd_);
+        inotifyFd_ = -1;
+        return false;
+    }
+#else
+    return false;
+#endif
+    
+    running_ = true;
+    finished_ = false;
+    thread_ = std::thread([this]() {
+#if defined(_WIN32)
+        // GetCurrentThread() is a pseudo-handle; stop() needs a real one
+        HANDLE self = nullptr;
+        if (DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(),
+                            &self, 0, FALSE, DUPLICATE_SAME_ACCESS)) {
+            threadHandle_ = self;
+        }
+#endif
+        run();
+        finished_ = true;
+    });
+    return true;
+}
+
+void FileWatcher::stop() {
+    if (!running_) {
+        return;
+    }
+    running_ = false;
+    
+#if defined(_WIN32)
+    // The watcher thread blocks in ReadDirectoryChangesW; keep cancelling
+    // until it notices, in case it had not entered the call yet
+    while (!finished_) {
+        if (HANDLE thread = threadHandle_.load()) {
+            CancelSynchronousIo(thread);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+#endif
+    
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    
+#if defined(_WIN32)
+    if (HANDLE thread = threadHandle_.exchange(nullptr)) {
+        CloseHandle(thread);
+    }
+    CloseHandle(directoryHandle_);
+    directoryHandle_ = INVALID_HANDLE_VALUE;
+#elif defined(__linux__)
+    close(inotifyFd_);
+    inotifyFd_ = -1;
+    watches_.clear();
+#endif
+}
+
+#if defined(_WIN32)
+
+void FileWatcher::run() {
+    alignas(DWORD) char buffer[64 * 1024];
+    const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+                         FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE;
+    
+    while (running_) {
+        DWORD bytes = 0;
+        if (!ReadDirectoryChangesW(directoryHandle_, buffer, sizeof(buffer), TRUE,
+                                   filter, &bytes, nullptr, nullptr)) {
+            break;
+        }
+        
+        // A zero-length result means the change buffer overflowed
+        if (bytes == 0) {
+            callback_(root_);
+            continue;
+        }
+        
+        auto* info = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(buffer);
+        for (;;) {
+            std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+            callback_((std::filesystem::path(root_) / name).string());
+            
+            if (info->NextEntryOffset == 0) {
+                break;
+            }
+            info = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(
+                reinterpret_cast<char*>(info) + info->NextEntryOffset);
+        }
+    }
+}
+
+#elif defined(__linux__)
+
+void FileWatcher::addWatches(const std::string& directory) {
+    const uint32_t mask = IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE |
+                          IN_DELETE_SELF | IN_MOVED_FROM | IN_MOVED_TO | IN_MOVE_SELF;
+    
+    // inotify is not recursive: watch every directory in the tree
+    int wd = inotify_add_watch(inotifyFd_, directory.c_str(), mask);
+    if (wd >= 0) {
+        watches_[wd] = directory;
+    }
+    
+    try {
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+            if (entry.is_directory()) {
+                std::string path = entry.path().string();
+                wd = inotify_add_watch(inotifyFd_, path.c_str(), mask);
+                if (wd >= 0) {
+                    watches_[wd] = path;
+                }
+            }
+        }
+    } catch (...) {
+        // Directory vanished while walking; its events will report it
+    }
+}
+
+void FileWatcher::run() {
+    alignas(inotify_event) char buffer[64 * 1024];
+    
+    while (running_) {
+        pollfd fd = {inotifyFd_, POLLIN, 0};
+        if (poll(&fd, 1, 250) <= 0) {
+            continue;
+        }
+        
+        ssize_t length = read(inotifyFd_, buffer, sizeof(buffer));
+        if (length <= 0) {
+            continue;
+        }
+        
+        for (char* ptr = buffer; ptr < buffer + length; ) {
+            const auto* event = reinterpret_cast<const inotify_event*>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+            
+            if (event->mask & IN_Q_OVERFLOW) {
+                callback_(root_);
+                continue;
+            }
+            
+            auto it = watches_.find(event->wd);
+            if (it == watches_.end()) {
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                watches_.erase(it);
+                continue;
+            }
+            
+            std::string path = event->len > 0 
+                ? (std::filesystem::path(it->second) / event->name).string()
+                : it->second;
+            
+            if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                addWatches(path);
+            }
+            callback_(path);
+        }
+    }
+}
+
+#else
+
+void FileWatcher::run() {
+}
+
+#endif
+
+} // namespace httpapi 
@@ -0,0 +1,372 @@
+#include "httpapi/headers.hpp"
+#include <algorithm>
+
+namespace httpapi {
+
+namespace {
+
+// Indexed by HeaderId
+constexpr std::string_view kCanonicalNames[] = {
+    "",
+    "Accept",
+    "Accept-Encoding",
+    "Accept-Ranges",
+    "Age",
+    "Authorization",
+    "Cache-Control",
+    "Connection",
+    "Content-Disposition",
+    "Content-Encoding",
+    "Content-Length",
+    "Content-Range",
+    "Content-Type",
+    "Cookie",
+    "Date",
+    "ETag",
+    "Expires",
+    "Host",
+    "If-Modified-Since",
+    "If-None-Match",
+    "If-Range",
+    "Last-Modified",
+    "Location",
+    "Pragma",
+    "Range",
+    "Server",
+    "Set-Cookie",
+    "Transfer-Encoding",
+    "User-Agent",
+    "Vary"
+};
+
+static_assert(sizeof(kCanonicalNames) / sizeof(kCanonicalNames[0]) == static_cast<size_t>(HeaderId::Count),
+              "every HeaderId needs a canonical name");
+static_assert(static_cast<size_t>(HeaderId::Count) <= 64, "repeated_ holds one bit per HeaderId");
+
+char asciiLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+uint64_t bitOf(HeaderId id) {
+    return uint64_t{1} << static_cast<unsigned>(id);
+}
+
+bool matches(const HeaderField& field, HeaderId id, std::string_view name) {
+    if (id != HeaderId::Other) {
+        return field.id == id;
+    }
+    return field.id == HeaderId::Other && Headers::equalsIgnoreCase(field.customName, name);
+}
+
+} // namespace
+
+std::string_view HeaderField::name() const {
+    return id == HeaderId::Other ? std::string_view(customName) : Headers::canonicalName(id);
+}
+
+Headers::Headers() {
+    first_.fill(kNoField);
+}
+
+HeaderId Headers::lookup(std::string_view name) {
+    if (name.empty()) {
+        return HeaderId::Other;
+    }
+    
+    // Length and first letter leave at most two candidates, which are then
+    // compared in full
+    HeaderId first = HeaderId::Other;
+    HeaderId second = HeaderId::Other;
+    char initial = asciiLower(name[0]);
+    switch (name.size()) {
+        case 3:
+            if (initial == 'a') first = HeaderId::Age;
+            break;
+        case 4:
+            if (initial == 'd') first = HeaderId::Date;
+            else if (initial == 'e') first = HeaderId::ETag;
+            else if (initial == 'h') first = HeaderId::Host;
+            else if (initial == 'v') first = HeaderId::Vary;
+            break;
+        case 5:
+            if (initial == 'r') first = HeaderId::Range;
+            break;
+        case 6:
+            if (initial == 'a') first = HeaderId::Accept;
+            else if (initial == 'c') first = HeaderId::Cookie;
+            else if (initial == 'p') first = HeaderId::Pragma;
+            else if (initial == 's') first = HeaderId::Server;
+            break;
+        case 7:
+            if (initial == 'e') first = HeaderId::Expires;
+            break;
+        case 8:
+            if (initial == 'i') first = HeaderId::IfRange;
+            else if (initial == 'l') first = HeaderId::Location;
+            break;
+        case 10:
+            if (initial == 'c') first = HeaderId::Connection;
+            else if (initial == 's') first = HeaderId::SetCookie;
+            else if (initial == 'u') first = HeaderId::UserAgent;
+            break;
+        case 12:
+            if (initial == 'c') first = HeaderId::ContentType;
+            break;
+        case 13:
+            if (initial == 'a') {
+                first = HeaderId::AcceptRanges;
+                second = HeaderId::Authorization;
+            } else if (initial == 'c') {
+                first = HeaderId::CacheControl;
+                second = HeaderId::ContentRange;
+            } else if (initial == 'i') {
+                first = HeaderId::IfNoneMatch;
+            } else if (initial == 'l') {
+                first = HeaderId::LastModified;
+            }
+            break;
+        case 14:
+            if (initial == 'c') first = HeaderId::ContentLength;
+            break;
+        case 15:
+            if (initial == 'a') first = HeaderId::AcceptEncoding;
+            break;
+        case 16:
+            if (initial == 'c') first = HeaderId::ContentEncoding;
+            break;
+        case 17:
+            if (initial == 'i') first = HeaderId::IfModifiedSince;
+            else if (initial == 't') first = HeaderId::TransferEncoding;
+            break;
+        case 19:
+            if (initial == 'c') first = HeaderId::ContentDisposition;
+            break;
+        default:
+            break;
+    }
+    if (first != HeaderId::Other && equalsIgnoreCase(canonicalName(first), name)) {
+        return first;
+    }
+    if (second != HeaderId::Other && equalsIgnoreCase(canonicalName(second), name)) {
+        return second;
+    }
+    return HeaderId::Other;
+}
+
+std::string_view Headers::canonicalName(HeaderId id) {
+    size_t index = static_cast<size_t>(id);
+    return index < kKnownCount ? kCanonicalNames[index] : std::string_view();
+}
+
+bool Headers::equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i] != b[i] && asciiLower(a[i]) != asciiLower(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t Headers::indexOf(std::string_view name, HeaderId id) const {
+    if (id != HeaderId::Other) {
+        uint32_t index = first_[static_cast<size_t>(id)];
+        return index == kNoField ? std::string::npos : index;
+    }
+    const HeaderField* all = fields();
+    for (size_t i = 0; i < count_; ++i) {
+        if (matches(all[i], id, name)) {
+            return i;
+        }
+    }
+    return std::string::npos;
+}
+
+const std::string* Headers::find(std::string_view name) const {
+    size_t index = indexOf(name, lookup(name));
+    return index == std::string::npos ? nullptr : &fields()[index].value;
+}
+
+const std::string* Headers::find(HeaderId id) const {
+    size_t index = indexOf(std::string_view(), id);
+    return index == std::string::npos ? nullptr : &fields()[index].value;
+}
+
+std::string Headers::get(std::string_view name) const {
+    const std::string* value = find(name);
+    return value ? *value : std::string();
+}
+
+std::string Headers::get(HeaderId id) const {
+    const std::string* value = find(id);
+    return value ? *value : std::string();
+}
+
+std::vector<std::string_view> Headers::getAll(std::string_view name) const {
+    HeaderId id = lookup(name);
+    std::vector<std::string_view> values;
+    for (const auto& field : *this) {
+        if (matches(field, id, name)) {
+            values.push_back(field.value);
+        }
+    }
+    return values;
+}
+
+void Headers::set(std::string_view name, std::string value) {
+    assign(lookup(name), name, std::move(value));
+}
+
+void Headers::set(HeaderId id, std::string value) {
+    assign(id, canonicalName(id), std::move(value));
+}
+
+void Headers::add(std::string_view name, std::string value) {
+    append(lookup(name), name, std::move(value));
+}
+
+void Headers::add(HeaderId id, std::string value) {
+    append(id, canonicalName(id), std::move(value));
+}
+
+size_t Headers::erase(std::string_view name) {
+    return eraseMatching(lookup(name), name);
+}
+
+size_t Headers::erase(HeaderId id) {
+    return eraseMatching(id, canonicalName(id));
+}
+
+void Headers::merge(const Headers& other) {
+    // Drop every name `other` has first, so its repeated values all survive
+    for (size_t i = 0; i < other.count_; ++i) {
+        const HeaderField& field = other.fields()[i];
+        if (other.indexOf(field.name(), field.id) == i) {
+            eraseMatching(field.id, field.name());
+        }
+    }
+    for (const auto& field : other) {
+        append(field.id, field.name(), field.value);
+    }
+}
+
+void Headers::clear() {
+    truncate(0);
+    first_.fill(kNoField);
+    repeated_ = 0;
+}
+
+void Headers::push(HeaderField field) {
+    if (!spilled_ && count_ < kInlineFields) {
+        inline_[count_++] = std::move(field);
+        return;
+    }
+    if (!spilled_) {
+        // Move everything over so the fields stay contiguous
+        overflow_.reserve(2 * kInlineFields);
+        for (size_t i = 0; i < count_; ++i) {
+            overflow_.push_back(std::move(inline_[i]));
+            inline_[i] = HeaderField();
+        }
+        spilled_ = true;
+    }
+    overflow_.push_back(std::move(field));
+    ++count_;
+}
+
+void Headers::truncate(size_t count) {
+    if (spilled_) {
+        overflow_.erase(overflow_.begin() + static_cast<std::ptrdiff_t>(count), overflow_.end());
+        if (count == 0) {
+            spilled_ = false;
+        }
+    } else {
+        // Keep the strings' capacity for reuse, but not their contents
+        for (size_t i = count; i < count_; ++i) {
+            inline_[i].id = HeaderId::Other;
+            inline_[i].customName.clear();
+            inline_[i].value.clear();
+        }
+    }
+    count_ = count;
+}
+
+void Headers::append(HeaderId id, std::string_view name, std::string value) {
+    if (id != HeaderId::Other) {
+        uint32_t& first = first_[static_cast<size_t>(id)];
+        if (first == kNoField) {
+            first = static_cast<uint32_t>(count_);
+        } else {
+            repeated_ |= bitOf(id);
+        }
+    }
+    
+    HeaderField field;
+    field.id = id;
+    if (id == HeaderId::Other) {
+        field.customName.assign(name);
+    }
+    field.value = std::move(value);
+    push(std::move(field));
+}
+
+void Headers::assign(HeaderId id, std::string_view name, std::string value) {
+    size_t index = indexOf(name, id);
+    if (index == std::string::npos) {
+        append(id, name, std::move(value));
+        return;
+    }
+    HeaderField* all = fields();
+    all[index].value = std::move(value);
+    
+    // Later duplicates go; for well-known ids only when there are any
+    if (id == HeaderId::Other || (repeated_ & bitOf(id))) {
+        HeaderField* end = all + count_;
+        HeaderField* removed = std::remove_if(all + index + 1, end, [&](const HeaderField& field) {
+            return matches(field, id, name);
+        });
+        if (removed != end) {
+            truncate(static_cast<size_t>(removed - all));
+            reindex();
+        }
+    }
+}
+
+size_t Headers::eraseMatching(HeaderId id, std::string_view name) {
+    if (id != HeaderId::Other && first_[static_cast<size_t>(id)] == kNoField) {
+        return 0;
+    }
+    HeaderField* all = fields();
+    HeaderField* end = all + count_;
+    HeaderField* removed = std::remove_if(all, end, [&](const HeaderField& field) {
+        return matches(field, id, name);
+    });
+    size_t count = static_cast<size_t>(end - removed);
+    if (count > 0) {
+        truncate(static_cast<size_t>(removed - all));
+        reindex();
+    }
+    return count;
+}
+
+void Headers::reindex() {
+    first_.fill(kNoField);
+    repeated_ = 0;
+    const HeaderField* all = fields();
+    for (size_t i = 0; i < count_; ++i) {
+        HeaderId id = all[i].id;
+        if (id == HeaderId::Other) {
+            continue;
+        }
+        uint32_t& first = first_[static_cast<size_t>(id)];
+        if (first == kNoField) {
+            first = static_cast<uint32_t>(i);
+        } else {
+            repeated_ |= bitOf(id);
+        }
+    }
+}
+
+} // namespace httpapi 
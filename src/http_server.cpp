@@ -1,10 +1,10 @@
 #include "httpapi/http_server.hpp"
 #include "httpapi/utils.hpp"
-#include "httpapi/static_files.hpp"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
 #include <cstring>
+#include <charconv>
 #include <winsock2.h>
 #include <ws2tcpip.h>
 
@@ -13,6 +13,11 @@ namespace httpapi {
 HttpServer::HttpServer() 
     : serverSocket_(INVALID_SOCKET), running_(false), port_(3000), host_("0.0.0.0") {
     router_ = std::make_unique<Router>();
+    middleware_ = std::make_unique<Middleware>();
+    staticFiles_ = std::make_unique<StaticFileHandler>();
+    notFoundHandler_ = [](Request&, Response& res) {
+        res.status(404).send("Not Found");
+    };
     initializeWinsock();
 }
 
@@ -57,26 +62,38 @@ HttpServer& HttpServer::patch(const std::string& path, RequestHandler handler) {
     return *this;
 }
 
+bool HttpServer::removeRoute(const std::string& method, const std::string& path) {
+    return router_->remove(Utils::toUpperCase(method), path);
+}
+
 HttpServer& HttpServer::use(MiddlewareFunction middleware) {
-    globalMiddleware_.push_back(middleware);
+    middleware_->use(middleware);
     return *this;
 }
 
 HttpServer& HttpServer::use(const std::string& path, MiddlewareFunction middleware) {
-    globalMiddleware_.push_back(middleware);
+    middleware_->use(path, middleware);
     return *this;
 }
 
-HttpServer& HttpServer::static_(const std::string& path, const std::string& directory) {
-    staticPaths_[path] = directory;
+HttpServer& HttpServer::static_(const std::string& path, const std::string& directory,
+                                const StaticFileOptions& options) {
+    staticFiles_->setStaticPath(path, directory, options);
     return *this;
 }
 
+std::string HttpServer::assetUrl(const std::string& path) const {
+    return staticFiles_->assetUrl(path);
+}
+
 void HttpServer::start() {
     if (running_) {
         return;
     }
 
+    // Flatten middleware into per-route chains before serving
+    router_->setMiddleware(middleware_.get());
+
     // Create socket
     serverSocket_ = socket(AF_INET, SOCK_STREAM, 0);
     if (serverSocket_ == INVALID_SOCKET) {
@@ -112,6 +129,10 @@ void HttpServer::start() {
         return;
     }
 
+    // Watch static mounts so their in-memory file cache stays current; only
+    // once listening, so a failed start leaves no watcher threads behind
+    staticFiles_->start();
+
     std::cout << "Server listening on " << host_ << ":" << port_ << std::endl;
     running_ = true;
 
@@ -153,6 +174,8 @@ void HttpServer::stop() {
         serverThread_.join();
     }
 
+    staticFiles_->stop();
+
     std::cout << "Server stopped" << std::endl;
 }
 
@@ -185,7 +208,7 @@ void HttpServer::handleClient(SOCKET clientSocket) {
         // Parse URL
         auto urlParts = Utils::parseUrl(req.url);
         req.path = urlParts.first;
-        req.queryString = urlParts.second;
+        req.setQueryString(urlParts.second);
     }
 
     // Parse headers
@@ -196,9 +219,8 @@ void HttpServer::handleClient(SOCKET clientSocket) {
 
         size_t colonPos = line.find(':');
         if (colonPos != std::string::npos) {
-            std::string name = Utils::normalizeHeaderName(line.substr(0, colonPos));
-            std::string value = Utils::trim(line.substr(colonPos + 1));
-            req.headers[name] = value;
+            std::string_view name = std::string_view(line).substr(0, colonPos);
+            req.headers.add(name, Utils::trim(line.substr(colonPos + 1)));
         }
     }
 
@@ -207,17 +229,28 @@ void HttpServer::handleClient(SOCKET clientSocket) {
     while (std::getline(requestStream, line)) {
         body += line + "\n";
     }
-    req.body = body;
-
-    // Parse query parameters
-    req.parseQueryString();
+    req.setBody(std::move(body));
 
     // Process request through middleware and router
     processRequest(req, res);
 
-    // Send response
-    std::string responseStr = res.toString();
-    sendResponse(clientSocket, responseStr);
+    // Streamed bodies use chunked encoding; HTTP/1.0 clients get the raw
+    // bytes, delimited by closing the connection
+    bool streaming = res.isStreaming();
+    bool chunked = streaming && req.protocol != "HTTP/1.0";
+    if (streaming && !chunked) {
+        res.headers.erase(HeaderId::TransferEncoding);
+    }
+
+    // Send response; headers and body go out separately so a file-backed
+    // body is written straight from its mapping
+    if (sendResponse(clientSocket, res.headerString())) {
+        if (!streaming) {
+            sendResponse(clientSocket, res.bodyView());
+        } else if (req.method != "HEAD") {
+            sendStream(clientSocket, res.streamProducer(), chunked);
+        }
+    }
 
     closesocket(clientSocket);
 }
@@ -227,44 +260,12 @@ void HttpServer::processRequest(Request& req, Response& res) {
     res.setDefaultHeaders();
 
     // Check static files first
-    for (const auto& staticPath : staticPaths_) {
-        if (req.path.find(staticPath.first) == 0) {
-            StaticFileHandler staticHandler;
-            staticHandler.setStaticPath(staticPath.first, staticPath.second);
-            
-            std::string content, contentType;
-            int statusCode;
-            if (staticHandler.serveFile(req.path, content, contentType, statusCode)) {
-                res.status(statusCode);
-                res.header("Content-Type", contentType);
-                res.send(content);
-                return;
-            }
-        }
+    if (staticFiles_->serve(req, res)) {
+        return;
     }
 
-    // Execute global middleware
-    size_t middlewareIndex = 0;
-    std::function<void()> next = [&]() {
-        if (middlewareIndex < globalMiddleware_.size()) {
-            auto& middleware = globalMiddleware_[middlewareIndex++];
-            middleware(req, res, next);
-        } else {
-            // All middleware executed, now handle the request
-            if (!router_->handleRequest(req, res)) {
-                res.status(404).send("Not Found");
-            }
-        }
-    };
-
-    if (!globalMiddleware_.empty()) {
-        next();
-    } else {
-        // No middleware, handle request directly
-        if (!router_->handleRequest(req, res)) {
-            res.status(404).send("Not Found");
-        }
-    }
+    // Run the route's precompiled middleware chain and handler
+    router_->dispatch(req, res, notFoundHandler_);
 }
 
 std::string HttpServer::readRequest(SOCKET socket) {
@@ -285,8 +286,60 @@ std::string HttpServer::readRequest(SOCKET socket) {
     return request;
 }
 
-void HttpServer::sendResponse(SOCKET socket, const std::string& response) {
-    send(socket, response.c_str(), response.length(), 0);
+bool HttpServer::sendResponse(SOCKET socket, std::string_view response) {
+    // send() may accept fewer bytes than asked for, and takes an int length
+    const size_t maxChunk = 1024 * 1024;
+    while (!response.empty()) {
+        int chunk = static_cast<int>(std::min(response.size(), maxChunk));
+        int sent = send(socket, response.data(), chunk, 0);
+        if (sent <= 0) {
+            return false;
+        }
+        response.remove_prefix(static_cast<size_t>(sent));
+    }
+    return true;
+}
+
+void HttpServer::sendStream(SOCKET socket, Response::StreamProducer& producer, bool chunked) {
+    // Each piece goes out as soon as it is produced, so time to first byte
+    // and memory use do not depend on the length of the body
+    std::string piece;
+    std::string frame;
+    bool more = true;
+    while (more) {
+        piece.clear();
+        try {
+            more = producer(piece);
+        } catch (const std::exception& e) {
+            // Headers are already out; ending without the last chunk tells
+            // the client the body is incomplete
+            std::cerr << "Response stream failed: " << e.what() << std::endl;
+            return;
+        }
+        if (!chunked) {
+            if (!sendResponse(socket, piece)) {
+                return;
+            }
+            continue;
+        }
+
+        // A zero-size chunk would end the body early
+        frame.clear();
+        if (!piece.empty()) {
+            char size[16];
+            auto result = std::to_chars(size, size + sizeof(size), piece.size(), 16);
+            frame.append(size, result.ptr);
+            frame += "\r\n";
+            frame += piece;
+            frame += "\r\n";
+        }
+        if (!more) {
+            frame += "0\r\n\r\n";
+        }
+        if (!sendResponse(socket, frame)) {
+            return;
+        }
+    }
 }
 
 bool HttpServer::initializeWinsock() {
@@ -1,7 +1,9 @@
 #include "httpapi/json_handler.hpp"
 #include "httpapi/utils.hpp"
-#include <sstream>
-#include <iomanip>
+#include "httpapi/json_writer.hpp"
+#include "httpapi/json_string.hpp"
+#include <stdexcept>
+#include <typeinfo>
 
 namespace httpapi {
 
@@ -45,67 +47,97 @@ std::unordered_map<std::string, std::any> JsonHandler::parse(const std::string&
     return result;
 }
 
-std::string JsonHandler::stringify(const std::unordered_map<std::string, std::any>& data) {
-    std::ostringstream result;
-    result << "{";
-    
-    bool first = true;
-    for (const auto& pair : data) {
-        if (!first) {
-            result << ",";
+namespace {
+
+using JsonObject = std::unordered_map<std::string, std::any>;
+
+void writeAny(JsonWriter& writer, const std::any& value) {
+    const std::type_info& type = value.type();
+    if (type == typeid(std::string)) {
+        writer.value(*std::any_cast<std::string>(&value));
+    } else if (type == typeid(const char*)) {
+        writer.value(std::any_cast<const char*>(value));
+    } else if (type == typeid(int)) {
+        writer.value(std::any_cast<int>(value));
+    } else if (type == typeid(long)) {
+        writer.value(std::any_cast<long>(value));
+    } else if (type == typeid(long long)) {
+        writer.value(std::any_cast<long long>(value));
+    } else if (type == typeid(unsigned)) {
+        writer.value(std::any_cast<unsigned>(value));
+    } else if (type == typeid(unsigned long)) {
+        writer.value(std::any_cast<unsigned long>(value));
+    } else if (type == typeid(unsigned long long)) {
+        writer.value(std::any_cast<unsigned long long>(value));
+    } else if (type == typeid(double)) {
+        writer.value(std::any_cast<double>(value));
+    } else if (type == typeid(float)) {
+        writer.value(static_cast<double>(std::any_cast<float>(value)));
+    } else if (type == typeid(bool)) {
+        writer.value(std::any_cast<bool>(value));
+    } else if (type == typeid(JsonObject)) {
+        // Nested values as produced by parse()
+        writer.beginObject();
+        for (const auto& pair : *std::any_cast<JsonObject>(&value)) {
+            writer.key(pair.first);
+            writeAny(writer, pair.second);
         }
-        first = false;
-        
-        result << "\"" << escapeString(pair.first) << "\":";
-        
-        if (pair.second.type() == typeid(std::string)) {
-            result << "\"" << escapeString(std::any_cast<std::string>(pair.second)) << "\"";
-        } else if (pair.second.type() == typeid(int)) {
-            result << std::any_cast<int>(pair.second);
-        } else if (pair.second.type() == typeid(double)) {
-            result << std::any_cast<double>(pair.second);
-        } else if (pair.second.type() == typeid(bool)) {
-            result << (std::any_cast<bool>(pair.second) ? "true" : "false");
-        } else {
-            result << "null";
+        writer.endObject();
+    } else if (type == typeid(std::vector<std::any>)) {
+        writer.beginArray();
+        for (const auto& item : *std::any_cast<std::vector<std::any>>(&value)) {
+            writeAny(writer, item);
         }
+        writer.endArray();
+    } else {
+        writer.null();
     }
-    
-    result << "}";
-    return result.str();
+}
+
+void writeObject(JsonWriter& writer, const JsonObject& data) {
+    writer.beginObject();
+    for (const auto& pair : data) {
+        writer.key(pair.first);
+        writeAny(writer, pair.second);
+    }
+    writer.endObject();
+}
+
+} // namespace
+
+std::string JsonHandler::stringify(const std::unordered_map<std::string, std::any>& data) {
+    std::string result;
+    JsonWriter writer(result);
+    writeObject(writer, data);
+    return result;
 }
 
 std::string JsonHandler::stringify(const std::vector<std::string>& array) {
-    std::ostringstream result;
-    result << "[";
-    
-    for (size_t i = 0; i < array.size(); ++i) {
-        if (i > 0) {
-            result << ",";
-        }
-        result << "\"" << escapeString(array[i]) << "\"";
+    std::string result;
+    JsonWriter writer(result);
+    writer.beginArray();
+    for (const auto& item : array) {
+        writer.value(item);
     }
-    
-    result << "]";
-    return result.str();
+    writer.endArray();
+    return result;
 }
 
 std::string JsonHandler::stringify(const std::vector<std::unordered_map<std::string, std::any>>& array) {
-    std::ostringstream result;
-    result << "[";
-    
-    for (size_t i = 0; i < array.size(); ++i) {
-        if (i > 0) {
-            result << ",";
-        }
-        result << stringify(array[i]);
-    }
-    
-    result << "]";
-    return result.str();
+    std::string result;
+    JsonWriter writer(result);
+    // Large exports are serialized in chunks across the shared thread pool
+    writer.parallelArray(array.size(), [&array](JsonWriter& itemWriter, size_t index) {
+        writeObject(itemWriter, array[index]);
+    });
+    return result;
 }
 
-bool JsonHandler::isValid(const std::string& json) {
+bool JsonHandler::isValid(const std::string& json, bool validateUtf8) {
+    // JSON text is UTF-8 (RFC 8259)
+    if (validateUtf8 && !JsonString::isValidUtf8(json)) {
+        return false;
+    }
     try {
         size_t pos = 0;
         skipWhitespace(json, pos);
@@ -118,62 +150,17 @@ bool JsonHandler::isValid(const std::string& json) {
 }
 
 std::string JsonHandler::escapeString(const std::string& str) {
-    std::ostringstream result;
-    for (char c : str) {
-        switch (c) {
-            case '"': result << "\\\""; break;
-            case '\\': result << "\\\\"; break;
-            case '\b': result << "\\b"; break;
-            case '\f': result << "\\f"; break;
-            case '\n': result << "\\n"; break;
-            case '\r': result << "\\r"; break;
-            case '\t': result << "\\t"; break;
-            default:
-                if (static_cast<unsigned char>(c) < 32) {
-                    result << "\\u" << std::hex << std::setw(4) << std::setfill('0') 
-                           << static_cast<int>(static_cast<unsigned char>(c));
-                } else {
-                    result << c;
-                }
-                break;
-        }
-    }
-    return result.str();
+    std::string result;
+    result.reserve(str.size());
+    JsonString::escape(str, result);
+    return result;
 }
 
 std::string JsonHandler::unescapeString(const std::string& str) {
     std::string result;
-    for (size_t i = 0; i < str.length(); ++i) {
-        if (str[i] == '\\' && i + 1 < str.length()) {
-            switch (str[i + 1]) {
-                case '"': result += '"'; i++; break;
-                case '\\': result += '\\'; i++; break;
-                case 'b': result += '\b'; i++; break;
-                case 'f': result += '\f'; i++; break;
-                case 'n': result += '\n'; i++; break;
-                case 'r': result += '\r'; i++; break;
-                case 't': result += '\t'; i++; break;
-                case 'u':
-                    if (i + 5 < str.length()) {
-                        std::string hex = str.substr(i + 2, 4);
-                        try {
-                            int unicode = std::stoi(hex, nullptr, 16);
-                            result += static_cast<char>(unicode);
-                            i += 5;
-                        } catch (...) {
-                            result += '\\';
-                        }
-                    } else {
-                        result += '\\';
-                    }
-                    break;
-                default:
-                    result += '\\';
-                    break;
-            }
-        } else {
-            result += str[i];
-        }
+    result.reserve(str.size());
+    if (const char* error = JsonString::unescape(str, result)) {
+        throw std::runtime_error(std::string("Invalid JSON string: ") + error);
     }
     return result;
 }
@@ -286,30 +273,28 @@ std::string JsonHandler::parseString(const std::string& json, size_t& pos) {
     }
     pos++; // Skip '"'
     
-    std::string result;
-    while (pos < json.length() && json[pos] != '"') {
-        if (json[pos] == '\\' && pos + 1 < json.length()) {
-            pos++; // Skip '\'
-            switch (json[pos]) {
-                case '"': result += '"'; break;
-                case '\\': result += '\\'; break;
-                case 'b': result += '\b'; break;
-                case 'f': result += '\f'; break;
-                case 'n': result += '\n'; break;
-                case 'r': result += '\r'; break;
-                case 't': result += '\t'; break;
-                default: result += '\\'; result += json[pos]; break;
-            }
-        } else {
-            result += json[pos];
+    // Find the closing quote, stepping over escapes; raw control characters
+    // are tolerated as before
+    const char* begin = json.data() + pos;
+    const char* end = json.data() + json.length();
+    const char* p = begin;
+    while (true) {
+        p = JsonString::findSpecial(p, end);
+        if (p == end || (*p == '\\' && end - p < 2)) {
+            throw std::runtime_error("Expected '\"'");
         }
-        pos++;
+        if (*p == '"') {
+            break;
+        }
+        p += *p == '\\' ? 2 : 1;
     }
     
-    if (pos >= json.length() || json[pos] != '"') {
-        throw std::runtime_error("Expected '\"'");
+    std::string result;
+    result.reserve(static_cast<size_t>(p - begin));
+    if (const char* error = JsonString::unescape(std::string_view(begin, static_cast<size_t>(p - begin)), result)) {
+        throw std::runtime_error(std::string("Invalid JSON string: ") + error);
     }
-    pos++; // Skip '"'
+    pos = static_cast<size_t>(p - json.data()) + 1; // Skip '"'
     
     return result;
 }
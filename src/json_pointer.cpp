@@ -0,0 +1,356 @@
+#include "httpapi/json_pointer.hpp"
+#include "httpapi/json_reader.hpp"
+#include <stdexcept>
+
+namespace httpapi {
+
+namespace {
+
+[[noreturn]] void fail(size_t offset, const char* message) {
+    throw std::runtime_error(std::string("Invalid JSON at offset ") +
+                             std::to_string(offset) + ": " + message);
+}
+
+size_t skipWhitespace(std::string_view json, size_t pos) {
+    while (pos < json.size()) {
+        char c = json[pos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+        ++pos;
+    }
+    return pos;
+}
+
+// pos is at the opening quote; returns the offset just past the closing one
+size_t skipString(std::string_view json, size_t pos) {
+    for (size_t i = pos + 1; i < json.size(); ++i) {
+        if (json[i] == '\\') {
+            ++i;
+        } else if (json[i] == '"') {
+            return i + 1;
+        }
+    }
+    fail(pos, "unterminated string");
+}
+
+// Returns the offset just past the value starting at pos. Containers are
+// matched by bracket counting only; their contents are not tokenized.
+size_t skipValue(std::string_view json, size_t pos) {
+    char c = json[pos];
+    if (c == '"') {
+        return skipString(json, pos);
+    }
+    if (c == '{' || c == '[') {
+        size_t depth = 0;
+        for (size_t i = pos; i < json.size(); ++i) {
+            switch (json[i]) {
+                case '"':
+                    i = skipString(json, i) - 1;
+                    break;
+                case '{':
+                case '[':
+                    ++depth;
+                    break;
+                case '}':
+                case ']':
+                    if (--depth == 0) {
+                        return i + 1;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        fail(pos, "unterminated container");
+    }
+    
+    // Number or literal: up to the next delimiter
+    size_t end = pos;
+    while (end < json.size()) {
+        char d = json[end];
+        if (d == ',' || d == '}' || d == ']' || d == ' ' || d == '\t' || d == '\n' || d == '\r') {
+            break;
+        }
+        ++end;
+    }
+    if (end == pos) {
+        fail(pos, "expected a value");
+    }
+    return end;
+}
+
+// "~1" is '/' and "~0" is '~' inside a reference token
+std::string unescapePointerToken(std::string_view token) {
+    std::string result;
+    result.reserve(token.size());
+    for (size_t i = 0; i < token.size(); ++i) {
+        if (token[i] != '~') {
+            result += token[i];
+        } else if (i + 1 < token.size() && (token[i + 1] == '0' || token[i + 1] == '1')) {
+            result += token[++i] == '0' ? '~' : '/';
+        } else {
+            throw std::runtime_error("Invalid JSON pointer: bad '~' escape");
+        }
+    }
+    return result;
+}
+
+void appendPointerToken(std::string& path, std::string_view name) {
+    for (char c : name) {
+        if (c == '~') {
+            path += "~0";
+        } else if (c == '/') {
+            path += "~1";
+        } else {
+            path += c;
+        }
+    }
+}
+
+// Array indices are "0" or digits without a leading zero
+bool parseIndex(std::string_view token, size_t& index) {
+    if (token.empty() || token.size() > 18 || (token[0] == '0' && token.size() > 1)) {
+        return false;
+    }
+    index = 0;
+    for (char c : token) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        index = index * 10 + static_cast<size_t>(c - '0');
+    }
+    return true;
+}
+
+// Reads a lone scalar and checks nothing follows it
+JsonToken readScalar(JsonReader& reader, std::string_view raw) {
+    reader.feed(raw);
+    reader.finish();
+    JsonToken token = reader.next();
+    if (reader.depth() != 0) {
+        throw std::runtime_error("JSON value is not a scalar");
+    }
+    return token;
+}
+
+void checkEnd(JsonReader& reader) {
+    reader.next(); // End, or throws on trailing characters
+}
+
+} // namespace
+
+JsonType JsonSlice::type() const {
+    if (raw_.empty()) {
+        return JsonType::Null;
+    }
+    switch (raw_[0]) {
+        case '{': return JsonType::Object;
+        case '[': return JsonType::Array;
+        case '"': return JsonType::String;
+        case 't': case 'f': return JsonType::Boolean;
+        case 'n': return JsonType::Null;
+        default: return JsonType::Number;
+    }
+}
+
+void JsonSlice::expect(JsonType expected) const {
+    if (!found()) {
+        throw std::runtime_error("JSON value not found");
+    }
+    if (type() != expected) {
+        throw std::runtime_error(std::string("JSON value is ") + JsonValue::typeName(type()) +
+                                 ", expected " + JsonValue::typeName(expected));
+    }
+}
+
+bool JsonSlice::asBool() const {
+    expect(JsonType::Boolean);
+    JsonReader reader;
+    readScalar(reader, raw_);
+    bool value = reader.boolean();
+    checkEnd(reader);
+    return value;
+}
+
+double JsonSlice::asNumber() const {
+    expect(JsonType::Number);
+    JsonReader reader;
+    readScalar(reader, raw_);
+    double value = reader.number();
+    checkEnd(reader);
+    return value;
+}
+
+int64_t JsonSlice::asInt() const {
+    expect(JsonType::Number);
+    JsonReader reader;
+    readScalar(reader, raw_);
+    int64_t value = reader.integer();
+    checkEnd(reader);
+    return value;
+}
+
+std::string JsonSlice::asString() const {
+    expect(JsonType::String);
+    JsonReader reader;
+    readScalar(reader, raw_);
+    std::string value(reader.text());
+    checkEnd(reader);
+    return value;
+}
+
+JsonDocument JsonSlice::parse() const {
+    if (!found()) {
+        throw std::runtime_error("JSON value not found");
+    }
+    return JsonDocument::parse(raw_);
+}
+
+void JsonPointerIndex::clear() {
+    json_ = std::string_view();
+    size_ = 0;
+    values_.clear();
+    cursors_.clear();
+}
+
+JsonSlice JsonPointerIndex::find(std::string_view json, std::string_view pointer) {
+    // The owner calls clear() when the text changes. A different length is
+    // caught here as well, so stale positions can never point past the end.
+    if (json.size() != size_) {
+        clear();
+        size_ = json.size();
+    }
+    json_ = json;
+    if (!pointer.empty() && pointer[0] != '/') {
+        throw std::runtime_error("Invalid JSON pointer: must start with '/'");
+    }
+    
+    std::string path;
+    Span current;
+    auto root = values_.find(path);
+    if (root != values_.end()) {
+        current = root->second;
+    } else {
+        size_t start = skipWhitespace(json_, 0);
+        if (start == json_.size()) {
+            return JsonSlice();
+        }
+        // The root's extent is only measured if the root itself is asked for
+        current = Span{start, std::string_view::npos};
+        values_.emplace(path, current);
+    }
+    
+    // Walk one reference token at a time, scanning only where the cache
+    // has no entry yet
+    size_t pos = 0;
+    while (pos < pointer.size()) {
+        size_t end = pointer.find('/', pos + 1);
+        if (end == std::string_view::npos) {
+            end = pointer.size();
+        }
+        size_t parentLength = path.size();
+        path.append(pointer.data() + pos, end - pos);
+        
+        auto cached = values_.find(path);
+        if (cached != values_.end()) {
+            current = cached->second;
+        } else {
+            std::string parentPath = path.substr(0, parentLength);
+            Span parent = current;
+            if (!scanFor(parentPath, parent, pointer.substr(pos + 1, end - pos - 1), current)) {
+                return JsonSlice();
+            }
+        }
+        pos = end;
+    }
+    if (current.length == std::string_view::npos) {
+        current.length = skipValue(json_, current.offset) - current.offset;
+        values_[path] = current;
+    }
+    return JsonSlice(json_.substr(current.offset, current.length));
+}
+
+bool JsonPointerIndex::scanFor(const std::string& parentPath, const Span& parent,
+                               std::string_view token, Span& found) {
+    char open = json_[parent.offset];
+    if (open != '{' && open != '[') {
+        return false;
+    }
+    bool object = open == '{';
+    char close = object ? '}' : ']';
+    
+    std::string name;
+    size_t index = 0;
+    if (object) {
+        name = unescapePointerToken(token);
+    } else if (!parseIndex(token, index)) {
+        return false;
+    }
+    
+    Cursor& cursor = cursors_.try_emplace(parentPath, Cursor{parent.offset + 1, 0, false}).first->second;
+    std::string childPath;
+    std::string key;
+    while (!cursor.complete) {
+        size_t pos = skipWhitespace(json_, cursor.next);
+        if (pos >= json_.size()) {
+            fail(pos, "unexpected end of input");
+        }
+        if (json_[pos] == close && cursor.index == 0) {
+            cursor.complete = true;
+            break;
+        }
+        
+        childPath = parentPath;
+        childPath += '/';
+        bool match;
+        if (object) {
+            if (json_[pos] != '"') {
+                fail(pos, "expected object key");
+            }
+            size_t keyEnd = skipString(json_, pos);
+            std::string_view rawKey = json_.substr(pos + 1, keyEnd - pos - 2);
+            if (rawKey.find('\\') == std::string_view::npos) {
+                key.assign(rawKey.data(), rawKey.size());
+            } else {
+                key = JsonSlice(json_.substr(pos, keyEnd - pos)).asString();
+            }
+            match = key == name;
+            appendPointerToken(childPath, key);
+            
+            pos = skipWhitespace(json_, keyEnd);
+            if (pos >= json_.size() || json_[pos] != ':') {
+                fail(pos, "expected ':'");
+            }
+            pos = skipWhitespace(json_, pos + 1);
+            if (pos >= json_.size()) {
+                fail(pos, "unexpected end of input");
+            }
+        } else {
+            match = cursor.index == index;
+            childPath += std::to_string(cursor.index);
+        }
+        ++cursor.index;
+        
+        size_t valueEnd = skipValue(json_, pos);
+        Span span{pos, valueEnd - pos};
+        values_.emplace(childPath, span); // the first of duplicate keys wins
+        
+        pos = skipWhitespace(json_, valueEnd);
+        if (pos < json_.size() && json_[pos] == ',') {
+            cursor.next = pos + 1;
+        } else if (pos < json_.size() && json_[pos] == close) {
+            cursor.complete = true;
+        } else {
+            fail(pos, object ? "expected ',' or '}'" : "expected ',' or ']'");
+        }
+        
+        if (match) {
+            found = span;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace httpapi 
@@ -0,0 +1,440 @@
+#include "httpapi/json_reader.hpp"
+#include "httpapi/json_string.hpp"
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace httpapi {
+
+namespace {
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)? over the whole range
+bool validNumber(const char* p, const char* end, bool& integral) {
+    integral = true;
+    if (p < end && *p == '-') {
+        ++p;
+    }
+    if (p == end || !isDigit(*p)) {
+        return false;
+    }
+    if (*p++ != '0') {
+        while (p < end && isDigit(*p)) {
+            ++p;
+        }
+    }
+    if (p < end && *p == '.') {
+        integral = false;
+        if (++p == end || !isDigit(*p)) {
+            return false;
+        }
+        while (p < end && isDigit(*p)) {
+            ++p;
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        integral = false;
+        ++p;
+        if (p < end && (*p == '+' || *p == '-')) {
+            ++p;
+        }
+        if (p == end || !isDigit(*p)) {
+            return false;
+        }
+        while (p < end && isDigit(*p)) {
+            ++p;
+        }
+    }
+    return p == end;
+}
+
+} // namespace
+
+JsonReader::JsonReader()
+    : JsonReader(Limits()) {
+}
+
+JsonReader::JsonReader(const Limits& limits)
+    : limits_(limits), pos_(0), consumed_(0), fed_(0), finished_(false),
+      state_(State::Value), last_(JsonToken::NeedMore), boolean_(false), integral_(false),
+      scan_(0), scanEscapes_(false), skipDepth_(0), skipInString_(false), skipEscape_(false),
+      skipValue_(false) {
+}
+
+void JsonReader::fail(const char* message) const {
+    throw std::runtime_error(std::string("Invalid JSON at offset ") +
+                             std::to_string(offset()) + ": " + message);
+}
+
+void JsonReader::feed(std::string_view chunk) {
+    if (finished_) {
+        throw std::runtime_error("JSON reader: feed() after finish()");
+    }
+    fed_ += chunk.size();
+    if (limits_.maxDocumentSize && fed_ > limits_.maxDocumentSize) {
+        throw std::runtime_error("JSON document exceeds size limit");
+    }
+    
+    // Drop what has been consumed; at most one partial token is left over
+    if (pos_ > 0) {
+        buffer_.erase(0, pos_);
+        consumed_ += pos_;
+        pos_ = 0;
+    }
+    buffer_.append(chunk.data(), chunk.size());
+}
+
+void JsonReader::finish() {
+    finished_ = true;
+}
+
+JsonToken JsonReader::next() {
+    if (skipDepth_ > 0 && !skipContainer()) {
+        return JsonToken::NeedMore;
+    }
+    
+    while (true) {
+        while (pos_ < buffer_.size()) {
+            char c = buffer_[pos_];
+            if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+                break;
+            }
+            ++pos_;
+        }
+        if (pos_ == buffer_.size()) {
+            if (!finished_) {
+                return JsonToken::NeedMore;
+            }
+            if (state_ == State::Done) {
+                return token(JsonToken::End);
+            }
+            fail("unexpected end of input");
+        }
+        
+        char c = buffer_[pos_];
+        switch (state_) {
+            case State::Done:
+                fail("trailing characters");
+            
+            case State::Colon:
+                if (c != ':') {
+                    fail("expected ':'");
+                }
+                ++pos_;
+                state_ = State::Value;
+                continue;
+            
+            case State::CommaOrEnd:
+                if (c == ',') {
+                    ++pos_;
+                    state_ = stack_.back() == '{' ? State::Key : State::Value;
+                    continue;
+                }
+                return closeContainer(c);
+            
+            case State::KeyOrEnd:
+                if (c == '}') {
+                    return closeContainer(c);
+                }
+                [[fallthrough]];
+            case State::Key:
+                if (c != '"') {
+                    fail("expected object key");
+                }
+                if (!readString()) {
+                    return JsonToken::NeedMore;
+                }
+                state_ = State::Colon;
+                return token(JsonToken::Key);
+            
+            case State::ValueOrEnd:
+                if (c == ']') {
+                    return closeContainer(c);
+                }
+                [[fallthrough]];
+            case State::Value: {
+                JsonToken t = readValue(c);
+                if (t == JsonToken::NeedMore || !skipValue_) {
+                    return t;
+                }
+                
+                // The value after a skipped key: swallow it
+                skipValue_ = false;
+                if (t == JsonToken::StartObject || t == JsonToken::StartArray) {
+                    stack_.pop_back();
+                    skipDepth_ = 1;
+                    if (!skipContainer()) {
+                        return JsonToken::NeedMore;
+                    }
+                }
+                continue;
+            }
+        }
+    }
+}
+
+void JsonReader::skip() {
+    if (last_ == JsonToken::StartObject || last_ == JsonToken::StartArray) {
+        stack_.pop_back();
+        skipDepth_ = 1;
+    } else if (last_ == JsonToken::Key) {
+        skipValue_ = true;
+    }
+    last_ = JsonToken::NeedMore;
+}
+
+JsonToken JsonReader::readValue(char c) {
+    switch (c) {
+        case '{':
+            pushContainer('{');
+            state_ = State::KeyOrEnd;
+            return token(JsonToken::StartObject);
+        case '[':
+            pushContainer('[');
+            state_ = State::ValueOrEnd;
+            return token(JsonToken::StartArray);
+        case '"':
+            if (!readString()) {
+                return JsonToken::NeedMore;
+            }
+            afterValue();
+            return token(JsonToken::String);
+        case 't':
+            if (!readLiteral("true", 4)) {
+                return JsonToken::NeedMore;
+            }
+            boolean_ = true;
+            afterValue();
+            return token(JsonToken::Boolean);
+        case 'f':
+            if (!readLiteral("false", 5)) {
+                return JsonToken::NeedMore;
+            }
+            boolean_ = false;
+            afterValue();
+            return token(JsonToken::Boolean);
+        case 'n':
+            if (!readLiteral("null", 4)) {
+                return JsonToken::NeedMore;
+            }
+            afterValue();
+            return token(JsonToken::Null);
+        default:
+            if (c != '-' && !isDigit(c)) {
+                fail("unexpected character");
+            }
+            if (!readNumber()) {
+                return JsonToken::NeedMore;
+            }
+            afterValue();
+            return token(JsonToken::Number);
+    }
+}
+
+void JsonReader::pushContainer(char c) {
+    if (stack_.size() >= limits_.maxDepth) {
+        fail("nesting exceeds depth limit");
+    }
+    stack_ += c;
+    ++pos_;
+}
+
+JsonToken JsonReader::closeContainer(char c) {
+    bool object = stack_.back() == '{';
+    if (c != (object ? '}' : ']')) {
+        fail(object ? "expected ',' or '}'" : "expected ',' or ']'");
+    }
+    ++pos_;
+    stack_.pop_back();
+    afterValue();
+    return token(object ? JsonToken::EndObject : JsonToken::EndArray);
+}
+
+bool JsonReader::readLiteral(const char* word, size_t length) {
+    size_t available = buffer_.size() - pos_;
+    size_t compare = available < length ? available : length;
+    if (std::memcmp(buffer_.data() + pos_, word, compare) != 0) {
+        fail("invalid literal");
+    }
+    if (available < length) {
+        if (finished_) {
+            fail("invalid literal");
+        }
+        return false;
+    }
+    pos_ += length;
+    return true;
+}
+
+bool JsonReader::readNumber() {
+    size_t end = pos_;
+    while (end < buffer_.size()) {
+        char c = buffer_[end];
+        if (!isDigit(c) && c != '-' && c != '+' && c != '.' && c != 'e' && c != 'E') {
+            break;
+        }
+        ++end;
+    }
+    if (end - pos_ > limits_.maxTokenSize) {
+        fail("number exceeds token size limit");
+    }
+    if (end == buffer_.size() && !finished_) {
+        return false;
+    }
+    
+    const char* first = buffer_.data() + pos_;
+    if (!validNumber(first, buffer_.data() + end, integral_)) {
+        fail("invalid number");
+    }
+    text_ = std::string_view(first, end - pos_);
+    pos_ = end;
+    return true;
+}
+
+bool JsonReader::readString() {
+    // Find the closing quote, resuming where the last chunk ran out
+    size_t start = pos_ + 1;
+    size_t i = start + scan_;
+    bool closed = false;
+    const char* data = buffer_.data();
+    while (i < buffer_.size()) {
+        i = static_cast<size_t>(JsonString::findSpecial(data + i, data + buffer_.size()) - data);
+        if (i == buffer_.size()) {
+            break;
+        }
+        char c = data[i];
+        if (c == '"') {
+            closed = true;
+            break;
+        }
+        if (c != '\\') {
+            fail("control character in string");
+        }
+        if (i + 1 >= buffer_.size()) {
+            break; // resume at the backslash
+        }
+        scanEscapes_ = true;
+        i += 2;
+    }
+    if (i - start > limits_.maxTokenSize) {
+        fail("string exceeds token size limit");
+    }
+    if (!closed) {
+        if (finished_) {
+            fail("unterminated string");
+        }
+        scan_ = i - start;
+        return false;
+    }
+    
+    std::string_view raw(buffer_.data() + start, i - start);
+    bool escapes = scanEscapes_;
+    scan_ = 0;
+    scanEscapes_ = false;
+    if (!escapes) {
+        text_ = raw;
+        pos_ = i + 1;
+        return true;
+    }
+    
+    decoded_.clear();
+    if (const char* error = JsonString::unescape(raw, decoded_)) {
+        fail(error);
+    }
+    text_ = decoded_;
+    pos_ = i + 1;
+    return true;
+}
+
+bool JsonReader::skipContainer() {
+    const char* data = buffer_.data();
+    size_t size = buffer_.size();
+    while (pos_ < size) {
+        char c = data[pos_++];
+        if (skipInString_) {
+            if (skipEscape_) {
+                skipEscape_ = false;
+            } else if (c == '\\') {
+                skipEscape_ = true;
+            } else if (c == '"') {
+                skipInString_ = false;
+            }
+            continue;
+        }
+        switch (c) {
+            case '"':
+                skipInString_ = true;
+                break;
+            case '{':
+            case '[':
+                if (stack_.size() + ++skipDepth_ > limits_.maxDepth) {
+                    fail("nesting exceeds depth limit");
+                }
+                break;
+            case '}':
+            case ']':
+                if (--skipDepth_ == 0) {
+                    afterValue();
+                    return true;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    if (finished_) {
+        fail("unexpected end of input");
+    }
+    return false;
+}
+
+double JsonReader::number() const {
+    double value = 0;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    if (std::from_chars(text_.data(), text_.data() + text_.size(), value).ec == std::errc()) {
+        return value;
+    }
+#endif
+    // Out of range, or no floating-point from_chars: strtod needs a
+    // terminated copy and gives +-inf / 0 on overflow
+    std::string literal(text_);
+    return std::strtod(literal.c_str(), nullptr);
+}
+
+int64_t JsonReader::integer() const {
+    if (!integral_) {
+        throw std::runtime_error("JSON number is not an integer");
+    }
+    int64_t value = 0;
+    auto result = std::from_chars(text_.data(), text_.data() + text_.size(), value);
+    if (result.ec != std::errc()) {
+        throw std::runtime_error("JSON integer out of range");
+    }
+    return value;
+}
+
+uint64_t JsonReader::unsignedInteger() const {
+    if (!integral_) {
+        throw std::runtime_error("JSON number is not an integer");
+    }
+    // "-0" is the one negative literal that fits
+    std::string_view digits = text_;
+    if (!digits.empty() && digits[0] == '-') {
+        if (digits.find_first_not_of('0', 1) == std::string_view::npos) {
+            return 0;
+        }
+        throw std::runtime_error("JSON integer out of range");
+    }
+    uint64_t value = 0;
+    auto result = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+    if (result.ec != std::errc()) {
+        throw std::runtime_error("JSON integer out of range");
+    }
+    return value;
+}
+
+} // namespace httpapi 
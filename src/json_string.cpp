@@ -0,0 +1,524 @@
+#include "httpapi/json_string.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define HTTPAPI_JSON_X86_64 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define HTTPAPI_TARGET_AVX2
+#else
+#define HTTPAPI_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace httpapi {
+
+namespace {
+
+bool isSpecial(unsigned char c) {
+    return c < 0x20 || c == '"' || c == '\\';
+}
+
+const char* findSpecialScalar(const char* p, const char* last) {
+    while (p < last && !isSpecial(static_cast<unsigned char>(*p))) {
+        ++p;
+    }
+    return p;
+}
+
+// Code point length of a well-formed sequence at p, or 0
+size_t validSequence(const unsigned char* p, const unsigned char* last) {
+    unsigned c = p[0];
+    if (c < 0x80) {
+        return 1;
+    }
+    size_t length;
+    unsigned code;
+    unsigned minimum;
+    if ((c & 0xE0) == 0xC0) {
+        length = 2, code = c & 0x1F, minimum = 0x80;
+    } else if ((c & 0xF0) == 0xE0) {
+        length = 3, code = c & 0x0F, minimum = 0x800;
+    } else if ((c & 0xF8) == 0xF0) {
+        length = 4, code = c & 0x07, minimum = 0x10000;
+    } else {
+        return 0;
+    }
+    if (static_cast<size_t>(last - p) < length) {
+        return 0;
+    }
+    for (size_t i = 1; i < length; ++i) {
+        if ((p[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+        code = (code << 6) | (p[i] & 0x3F);
+    }
+    if (code < minimum || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)) {
+        return 0;
+    }
+    return length;
+}
+
+bool validateScalar(const unsigned char* p, const unsigned char* last) {
+    while (p < last) {
+        size_t length = validSequence(p, last);
+        if (length == 0) {
+            return false;
+        }
+        p += length;
+    }
+    return true;
+}
+
+using FindSpecial = const char* (*)(const char* first, const char* last);
+using Escape = void (*)(const char* first, const char* last, std::string& out);
+using ValidateUtf8 = bool (*)(const unsigned char* first, const unsigned char* last);
+
+#if defined(HTTPAPI_JSON_X86_64)
+
+int countTrailingZeros(uint32_t bits) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(bits);
+#endif
+}
+
+// A byte is special when it equals '"' or '\\', or when min(byte, 0x1F)
+// leaves it unchanged, i.e. it is a control character
+uint32_t specialMaskSse2(const char* p) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+        _mm_cmpeq_epi8(_mm_min_epu8(v, control), v));
+    return static_cast<uint32_t>(_mm_movemask_epi8(special));
+}
+
+const char* findSpecialSse2(const char* p, const char* last) {
+    for (; last - p >= 16; p += 16) {
+        uint32_t mask = specialMaskSse2(p);
+        if (mask != 0) {
+            return p + countTrailingZeros(mask);
+        }
+    }
+    return findSpecialScalar(p, last);
+}
+
+HTTPAPI_TARGET_AVX2
+uint32_t specialMaskAvx2(const char* p) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i special = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)),
+        _mm256_cmpeq_epi8(_mm256_min_epu8(v, control), v));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(special));
+}
+
+HTTPAPI_TARGET_AVX2
+const char* findSpecialAvx2(const char* p, const char* last) {
+    for (; last - p >= 32; p += 32) {
+        uint32_t mask = specialMaskAvx2(p);
+        if (mask != 0) {
+            return p + countTrailingZeros(mask);
+        }
+    }
+    return findSpecialSse2(p, last);
+}
+
+// Skips 16-byte blocks of ASCII and checks the rest a code point at a time
+bool validateSse2(const unsigned char* p, const unsigned char* last) {
+    while (last - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        if (_mm_movemask_epi8(v) == 0) {
+            p += 16;
+            continue;
+        }
+        const unsigned char* blockEnd = p + 16;
+        while (p < blockEnd) {
+            size_t length = validSequence(p, last);
+            if (length == 0) {
+                return false;
+            }
+            p += length;
+        }
+    }
+    return validateScalar(p, last);
+}
+
+// Lookup-table validation (Keiser and Lemire, "Validating UTF-8 In Less Than
+// One Instruction Per Byte"). Every error shows up in the high nibble of
+// the previous byte, its low nibble or the high nibble of the current byte,
+// so three shuffles and an AND flag every bad pair of adjacent bytes.
+const uint8_t kTooShort = 1 << 0;   // lead byte not followed by a continuation
+const uint8_t kTooLong = 1 << 1;    // ASCII followed by a continuation
+const uint8_t kOverlong3 = 1 << 2;  // E0 80..9F
+const uint8_t kTooLarge = 1 << 3;   // F4 90..BF, or F5 and up
+const uint8_t kSurrogate = 1 << 4;  // ED A0..BF
+const uint8_t kOverlong2 = 1 << 5;  // C0, C1
+const uint8_t kTooLarge1000 = 1 << 6;
+const uint8_t kOverlong4 = 1 << 6;  // F0 80..8F
+const uint8_t kTwoConts = 1 << 7;   // two continuations in a row
+const uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+HTTPAPI_TARGET_AVX2
+__m256i table(uint8_t a0, uint8_t a1, uint8_t a2, uint8_t a3, uint8_t a4, uint8_t a5,
+              uint8_t a6, uint8_t a7, uint8_t a8, uint8_t a9, uint8_t a10, uint8_t a11,
+              uint8_t a12, uint8_t a13, uint8_t a14, uint8_t a15) {
+    return _mm256_setr_epi8(
+        char(a0), char(a1), char(a2), char(a3), char(a4), char(a5), char(a6), char(a7),
+        char(a8), char(a9), char(a10), char(a11), char(a12), char(a13), char(a14), char(a15),
+        char(a0), char(a1), char(a2), char(a3), char(a4), char(a5), char(a6), char(a7),
+        char(a8), char(a9), char(a10), char(a11), char(a12), char(a13), char(a14), char(a15));
+}
+
+// The input shifted right by N bytes, with the first N taken from the end
+// of the previous block
+template<int N>
+HTTPAPI_TARGET_AVX2
+__m256i previous(__m256i input, __m256i prior) {
+    return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prior, input, 0x21), 16 - N);
+}
+
+HTTPAPI_TARGET_AVX2
+__m256i highNibbles(__m256i v) {
+    return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+}
+
+HTTPAPI_TARGET_AVX2
+__m256i blockErrors(__m256i input, __m256i prior) {
+    const __m256i byte1HighTable = table(
+        kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+        kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+        kTooShort | kOverlong2,
+        kTooShort,
+        kTooShort | kOverlong3 | kSurrogate,
+        kTooShort | kTooLarge | kTooLarge1000 | kOverlong4);
+    const __m256i byte1LowTable = table(
+        kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+        kCarry | kOverlong2,
+        kCarry,
+        kCarry,
+        kCarry | kTooLarge,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000);
+    const __m256i byte2HighTable = table(
+        kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooShort, kTooShort, kTooShort, kTooShort);
+    
+    __m256i prev1 = previous<1>(input, prior);
+    __m256i special = _mm256_and_si256(
+        _mm256_and_si256(_mm256_shuffle_epi8(byte1HighTable, highNibbles(prev1)),
+                         _mm256_shuffle_epi8(byte1LowTable, _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)))),
+        _mm256_shuffle_epi8(byte2HighTable, highNibbles(input)));
+    
+    // Third and fourth bytes of 3- and 4-byte sequences must be continuations;
+    // those are the only places two continuations in a row are allowed
+    __m256i prev2 = previous<2>(input, prior);
+    __m256i prev3 = previous<3>(input, prior);
+    __m256i isThird = _mm256_subs_epu8(prev2, _mm256_set1_epi8(char(0xE0 - 0x80)));
+    __m256i isFourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8(char(0xF0 - 0x80)));
+    __m256i mustContinue = _mm256_and_si256(_mm256_or_si256(isThird, isFourth), _mm256_set1_epi8(char(0x80)));
+    return _mm256_xor_si256(mustContinue, special);
+}
+
+// Non-zero where the block ends partway through a sequence
+HTTPAPI_TARGET_AVX2
+__m256i incompleteTail(__m256i input) {
+    const __m256i limits = _mm256_setr_epi8(
+        char(255), char(255), char(255), char(255), char(255), char(255), char(255), char(255),
+        char(255), char(255), char(255), char(255), char(255), char(255), char(255), char(255),
+        char(255), char(255), char(255), char(255), char(255), char(255), char(255), char(255),
+        char(255), char(255), char(255), char(255), char(255),
+        char(0xF0 - 1), char(0xE0 - 1), char(0xC0 - 1));
+    return _mm256_subs_epu8(input, limits);
+}
+
+struct Utf8State {
+    __m256i error;
+    __m256i prior;
+    __m256i priorIncomplete;
+};
+
+HTTPAPI_TARGET_AVX2
+void checkBlock(Utf8State& state, __m256i input) {
+    if (_mm256_movemask_epi8(input) == 0) {
+        // ASCII only: fine unless the previous block left a sequence open
+        state.error = _mm256_or_si256(state.error, state.priorIncomplete);
+    } else {
+        state.error = _mm256_or_si256(state.error, blockErrors(input, state.prior));
+        state.priorIncomplete = incompleteTail(input);
+    }
+    state.prior = input;
+}
+
+HTTPAPI_TARGET_AVX2
+bool validateAvx2(const unsigned char* p, const unsigned char* last) {
+    Utf8State state{_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256()};
+    for (; last - p >= 32; p += 32) {
+        checkBlock(state, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+    }
+    if (p < last) {
+        // Zero padding reads as ASCII, so a truncated sequence still fails
+        alignas(32) unsigned char tail[32] = {};
+        std::memcpy(tail, p, static_cast<size_t>(last - p));
+        checkBlock(state, _mm256_load_si256(reinterpret_cast<const __m256i*>(tail)));
+    }
+    __m256i error = _mm256_or_si256(state.error, state.priorIncomplete);
+    return _mm256_testz_si256(error, error) != 0;
+}
+
+#endif
+
+void appendEscape(unsigned char c, std::string& out) {
+    static const char hexDigits[] = "0123456789abcdef";
+    switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default: {
+            char unicode[6] = {'\\', 'u', '0', '0', hexDigits[c >> 4], hexDigits[c & 0xF]};
+            out.append(unicode, sizeof(unicode));
+            break;
+        }
+    }
+}
+
+// Appends [run, last) escaped, given that `run` starts a block scan
+void escapeScalar(const char* run, const char* last, std::string& out) {
+    for (const char* p = run; p < last; ++p) {
+        if (isSpecial(static_cast<unsigned char>(*p))) {
+            out.append(run, static_cast<size_t>(p - run));
+            appendEscape(static_cast<unsigned char>(*p), out);
+            run = p + 1;
+        }
+    }
+    out.append(run, static_cast<size_t>(last - run));
+}
+
+#if defined(HTTPAPI_JSON_X86_64)
+
+// One load covers every special byte in the block, so dense escapes cost
+// a bit scan each rather than a fresh search
+void escapeSse2(const char* p, const char* last, std::string& out) {
+    const char* run = p;
+    for (; last - p >= 16; p += 16) {
+        for (uint32_t mask = specialMaskSse2(p); mask != 0; mask &= mask - 1) {
+            const char* special = p + countTrailingZeros(mask);
+            out.append(run, static_cast<size_t>(special - run));
+            appendEscape(static_cast<unsigned char>(*special), out);
+            run = special + 1;
+        }
+    }
+    out.append(run, static_cast<size_t>(p - run));
+    escapeScalar(p, last, out);
+}
+
+HTTPAPI_TARGET_AVX2
+void escapeAvx2(const char* p, const char* last, std::string& out) {
+    const char* run = p;
+    for (; last - p >= 32; p += 32) {
+        for (uint32_t mask = specialMaskAvx2(p); mask != 0; mask &= mask - 1) {
+            const char* special = p + countTrailingZeros(mask);
+            out.append(run, static_cast<size_t>(special - run));
+            appendEscape(static_cast<unsigned char>(*special), out);
+            run = special + 1;
+        }
+    }
+    out.append(run, static_cast<size_t>(p - run));
+    escapeSse2(p, last, out);
+}
+
+#endif
+
+struct Implementation {
+    FindSpecial findSpecial;
+    Escape escape;
+    ValidateUtf8 validateUtf8;
+    const char* name;
+};
+
+const Implementation& selectImplementation() {
+    static const Implementation selected = []() {
+#if defined(HTTPAPI_JSON_X86_64)
+        if (JsonString::cpuHasAvx2()) {
+            return Implementation{findSpecialAvx2, escapeAvx2, validateAvx2, "avx2"};
+        }
+        return Implementation{findSpecialSse2, escapeSse2, validateSse2, "sse2"};
+#else
+        return Implementation{findSpecialScalar, escapeScalar, validateScalar, "scalar"};
+#endif
+    }();
+    return selected;
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool parseHex4(std::string_view raw, size_t at, unsigned& code) {
+    if (raw.size() < 4 || at > raw.size() - 4) {
+        return false;
+    }
+    code = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        int digit = hexValue(raw[at + i]);
+        if (digit < 0) {
+            return false;
+        }
+        code = (code << 4) | static_cast<unsigned>(digit);
+    }
+    return true;
+}
+
+void appendUtf8(std::string& out, unsigned code) {
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+} // namespace
+
+const char* JsonString::findSpecial(const char* first, const char* last) {
+    return selectImplementation().findSpecial(first, last);
+}
+
+void JsonString::escape(std::string_view text, std::string& out) {
+    selectImplementation().escape(text.data(), text.data() + text.size(), out);
+}
+
+const char* JsonString::unescape(std::string_view raw, std::string& out) {
+    // Decoding never lengthens the text
+    out.reserve(out.size() + raw.size());
+    size_t p = 0;
+    while (true) {
+        // Escapes tend to cluster: copy a few bytes directly before paying
+        // for a full search and bulk append
+        size_t nearby = std::min(raw.size(), p + 8);
+        while (p < nearby && raw[p] != '\\') {
+            out += raw[p++];
+        }
+        if (p == nearby) {
+            size_t backslash = raw.find('\\', p);
+            if (backslash == std::string_view::npos) {
+                out.append(raw.data() + p, raw.size() - p);
+                return nullptr;
+            }
+            out.append(raw.data() + p, backslash - p);
+            p = backslash;
+        }
+        p += 1;
+        if (p >= raw.size()) {
+            return "invalid escape";
+        }
+        switch (raw[p++]) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                unsigned code;
+                if (!parseHex4(raw, p, code)) {
+                    return "invalid \\u escape";
+                }
+                p += 4;
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    // High surrogate: must pair with a low one
+                    unsigned low;
+                    if (raw.size() - p < 6 || raw[p] != '\\' || raw[p + 1] != 'u' ||
+                        !parseHex4(raw, p + 2, low) || low < 0xDC00 || low > 0xDFFF) {
+                        return "unpaired surrogate";
+                    }
+                    p += 6;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                    return "unpaired surrogate";
+                }
+                appendUtf8(out, code);
+                break;
+            }
+            default:
+                return "invalid escape";
+        }
+    }
+}
+
+bool JsonString::isValidUtf8(std::string_view text) {
+    const unsigned char* first = reinterpret_cast<const unsigned char*>(text.data());
+    return selectImplementation().validateUtf8(first, first + text.size());
+}
+
+bool JsonString::cpuHasAvx2() {
+#if defined(HTTPAPI_JSON_X86_64)
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+                      ((_xgetbv(0) & 6) == 6);
+    if (!osSavesYmm) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+#else
+    return false;
+#endif
+}
+
+const char* JsonString::implementation() {
+    return selectImplementation().name;
+}
+
+} // namespace httpapi 
@@ -0,0 +1,241 @@
+#include "httpapi/json_value.hpp"
+#include "httpapi/json_string.hpp"
+#include <stdexcept>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define HTTPAPI_JSON_X86_64 1
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define HTTPAPI_TARGET_AVX2
+#else
+#define HTTPAPI_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace httpapi {
+
+namespace {
+
+// One bit per byte of a 64-byte block
+struct BlockMasks {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t op;         // { } [ ] : ,
+    uint64_t whitespace;
+};
+
+using Classifier = void (*)(const char* block, BlockMasks& masks);
+
+#if !defined(HTTPAPI_JSON_X86_64)
+
+void classifyScalar(const char* block, BlockMasks& masks) {
+    masks = BlockMasks{0, 0, 0, 0};
+    for (int i = 0; i < 64; ++i) {
+        uint64_t bit = uint64_t(1) << i;
+        switch (block[i]) {
+            case '"': masks.quote |= bit; break;
+            case '\\': masks.backslash |= bit; break;
+            case '{': case '}': case '[': case ']': case ':': case ',': masks.op |= bit; break;
+            case ' ': case '\t': case '\n': case '\r': masks.whitespace |= bit; break;
+            default: break;
+        }
+    }
+}
+
+#else
+
+// '[' / '{' and ']' / '}' differ only in bit 0x20, so OR-ing it in folds
+// four bracket comparisons into two
+
+void classifySse2(const char* block, BlockMasks& masks) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i openBrace = _mm_set1_epi8('{');
+    const __m128i closeBrace = _mm_set1_epi8('}');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriageReturn = _mm_set1_epi8('\r');
+    
+    masks = BlockMasks{0, 0, 0, 0};
+    for (int i = 0; i < 4; ++i) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+        __m128i folded = _mm_or_si128(v, caseBit);
+        __m128i op = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(folded, openBrace), _mm_cmpeq_epi8(folded, closeBrace)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+        __m128i whitespace = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, newline), _mm_cmpeq_epi8(v, carriageReturn)));
+        
+        int shift = 16 * i;
+        masks.quote |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))) << shift;
+        masks.backslash |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)))) << shift;
+        masks.op |= uint64_t(uint16_t(_mm_movemask_epi8(op))) << shift;
+        masks.whitespace |= uint64_t(uint16_t(_mm_movemask_epi8(whitespace))) << shift;
+    }
+}
+
+HTTPAPI_TARGET_AVX2
+void classifyAvx2(const char* block, BlockMasks& masks) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i caseBit = _mm256_set1_epi8(0x20);
+    const __m256i openBrace = _mm256_set1_epi8('{');
+    const __m256i closeBrace = _mm256_set1_epi8('}');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i carriageReturn = _mm256_set1_epi8('\r');
+    
+    masks = BlockMasks{0, 0, 0, 0};
+    for (int i = 0; i < 2; ++i) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32 * i));
+        __m256i folded = _mm256_or_si256(v, caseBit);
+        __m256i op = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(folded, openBrace), _mm256_cmpeq_epi8(folded, closeBrace)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, colon), _mm256_cmpeq_epi8(v, comma)));
+        __m256i whitespace = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, tab)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, newline), _mm256_cmpeq_epi8(v, carriageReturn)));
+        
+        int shift = 32 * i;
+        masks.quote |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)))) << shift;
+        masks.backslash |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, backslash)))) << shift;
+        masks.op |= uint64_t(uint32_t(_mm256_movemask_epi8(op))) << shift;
+        masks.whitespace |= uint64_t(uint32_t(_mm256_movemask_epi8(whitespace))) << shift;
+    }
+}
+
+#endif
+
+struct Implementation {
+    Classifier classify;
+    const char* name;
+};
+
+const Implementation& selectImplementation() {
+    static const Implementation selected = []() {
+#if defined(HTTPAPI_JSON_X86_64)
+        if (JsonString::cpuHasAvx2()) {
+            return Implementation{classifyAvx2, "avx2"};
+        }
+        return Implementation{classifySse2, "sse2"};
+#else
+        return Implementation{classifyScalar, "scalar"};
+#endif
+    }();
+    return selected;
+}
+
+int countTrailingZeros(uint64_t bits) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+// Bit i set when an odd number of quotes precede byte i within the block
+uint64_t prefixXor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+// Bytes preceded by an odd-length run of backslashes, i.e. escaped ones.
+// carry says whether the previous block ended in such a run.
+uint64_t escapedBytes(uint64_t backslash, uint64_t& carry) {
+    const uint64_t evenBits = 0x5555555555555555ULL;
+    const uint64_t oddBits = ~evenBits;
+    
+    uint64_t runStarts = backslash & ~(backslash << 1);
+    uint64_t evenStartMask = evenBits ^ carry;
+    uint64_t evenStarts = runStarts & evenStartMask;
+    uint64_t oddStarts = runStarts & ~evenStartMask;
+    
+    uint64_t evenCarries = backslash + evenStarts;
+    uint64_t oddCarries = backslash + oddStarts;
+    bool endsOdd = oddCarries < backslash;
+    oddCarries |= carry;
+    carry = endsOdd ? 1 : 0;
+    
+    uint64_t evenCarryEnds = evenCarries & ~backslash;
+    uint64_t oddCarryEnds = oddCarries & ~backslash;
+    return (evenCarryEnds & oddBits) | (oddCarryEnds & evenBits);
+}
+
+} // namespace
+
+const char* JsonStructuralIndex::implementation() {
+    return selectImplementation().name;
+}
+
+void JsonStructuralIndex::build(const char* data, size_t size, std::vector<uint32_t>& positions) {
+    if (size >= UINT32_MAX) {
+        throw std::runtime_error("JSON value too large");
+    }
+    
+    Classifier classify = selectImplementation().classify;
+    positions.clear();
+    positions.reserve(size / 4 + 64);
+    
+    uint64_t backslashCarry = 0;
+    uint64_t inStringCarry = 0;
+    uint64_t scalarCarry = 1; // the text start counts as a token boundary
+    
+    char tail[64];
+    for (size_t offset = 0; offset < size; offset += 64) {
+        const char* block = data + offset;
+        if (size - offset < 64) {
+            // Whitespace padding never produces a position
+            std::memset(tail, ' ', sizeof(tail));
+            std::memcpy(tail, block, size - offset);
+            block = tail;
+        }
+        
+        BlockMasks masks;
+        classify(block, masks);
+        
+        uint64_t quotes = masks.quote & ~escapedBytes(masks.backslash, backslashCarry);
+        uint64_t inString = prefixXor(quotes) ^ inStringCarry;
+        inStringCarry = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+        
+        // Operators outside strings, plus every quote for now
+        uint64_t structurals = (masks.op & ~inString) | quotes;
+        
+        // Scalars (numbers, true/false/null) start right after whitespace or
+        // an operator
+        uint64_t boundaries = structurals | masks.whitespace;
+        uint64_t follows = (boundaries << 1) | scalarCarry;
+        scalarCarry = boundaries >> 63;
+        structurals |= follows & ~masks.whitespace & ~inString;
+        
+        // Keep opening quotes only; the parser finds each string's end itself
+        structurals &= ~(quotes & ~inString);
+        
+        while (structurals) {
+            positions.push_back(static_cast<uint32_t>(offset + countTrailingZeros(structurals)));
+            structurals &= structurals - 1;
+        }
+    }
+    
+    if (inStringCarry) {
+        throw std::runtime_error("Invalid JSON: unterminated string");
+    }
+}
+
+} // namespace httpapi 
@@ -0,0 +1,663 @@
+#include "httpapi/json_value.hpp"
+#include "httpapi/json_string.hpp"
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <limits>
+#include <algorithm>
+#include <charconv>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace httpapi {
+
+// JsonArena
+
+JsonArena::JsonArena(size_t firstBlockSize)
+    : cursor_(nullptr), end_(nullptr), nextBlockSize_(firstBlockSize < 256 ? 256 : firstBlockSize),
+      capacity_(0) {
+}
+
+void* JsonArena::allocate(size_t size, size_t alignment) {
+    uintptr_t current = reinterpret_cast<uintptr_t>(cursor_);
+    uintptr_t aligned = (current + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+    if (!cursor_ || aligned + size > reinterpret_cast<uintptr_t>(end_)) {
+        // Grow geometrically so a document needs only a few blocks
+        size_t blockSize = nextBlockSize_;
+        while (blockSize < size + alignment) {
+            blockSize *= 2;
+        }
+        blocks_.emplace_back(new char[blockSize]);
+        cursor_ = blocks_.back().get();
+        end_ = cursor_ + blockSize;
+        capacity_ += blockSize;
+        nextBlockSize_ = blockSize * 2;
+        
+        current = reinterpret_cast<uintptr_t>(cursor_);
+        aligned = (current + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+    }
+    cursor_ = reinterpret_cast<char*>(aligned + size);
+    return reinterpret_cast<void*>(aligned);
+}
+
+// JsonValue
+
+JsonValue::JsonValue()
+    : integer_(0), size_(0), type_(JsonType::Null), flags_(0) {
+}
+
+const char* JsonValue::typeName(JsonType type) {
+    switch (type) {
+        case JsonType::Null: return "null";
+        case JsonType::Boolean: return "boolean";
+        case JsonType::Number: return "number";
+        case JsonType::String: return "string";
+        case JsonType::Array: return "array";
+        case JsonType::Object: return "object";
+    }
+    return "unknown";
+}
+
+void JsonValue::typeError(JsonType expected) const {
+    throw std::runtime_error(std::string("JSON value is ") + typeName(type_) +
+                             ", expected " + typeName(expected));
+}
+
+bool JsonValue::asBool() const {
+    if (type_ != JsonType::Boolean) {
+        typeError(JsonType::Boolean);
+    }
+    return boolean_;
+}
+
+double JsonValue::asNumber() const {
+    if (type_ != JsonType::Number) {
+        typeError(JsonType::Number);
+    }
+    return (flags_ & kInteger) ? static_cast<double>(integer_) : number_;
+}
+
+int64_t JsonValue::asInt() const {
+    if (type_ != JsonType::Number) {
+        typeError(JsonType::Number);
+    }
+    if (!(flags_ & kInteger)) {
+        throw std::runtime_error("JSON number is not an integer");
+    }
+    return integer_;
+}
+
+std::string_view JsonValue::asString() const {
+    if (type_ != JsonType::String) {
+        typeError(JsonType::String);
+    }
+    return std::string_view((flags_ & kInline) ? inline_ : chars_, size_);
+}
+
+JsonRange<JsonValue> JsonValue::asArray() const {
+    if (type_ != JsonType::Array) {
+        typeError(JsonType::Array);
+    }
+    return JsonRange<JsonValue>(items_, size_);
+}
+
+JsonRange<JsonMember> JsonValue::asObject() const {
+    if (type_ != JsonType::Object) {
+        typeError(JsonType::Object);
+    }
+    return JsonRange<JsonMember>(members_, size_);
+}
+
+size_t JsonValue::size() const {
+    switch (type_) {
+        case JsonType::String:
+        case JsonType::Array:
+        case JsonType::Object:
+            return size_;
+        default:
+            return 0;
+    }
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const {
+    JsonRange<JsonValue> items = asArray();
+    if (index >= items.size()) {
+        throw std::runtime_error("JSON array index " + std::to_string(index) + " out of range");
+    }
+    return items[index];
+}
+
+const JsonValue& JsonValue::operator[](std::string_view key) const {
+    if (type_ != JsonType::Object) {
+        typeError(JsonType::Object);
+    }
+    const JsonValue* value = find(key);
+    if (!value) {
+        throw std::runtime_error("JSON object has no member \"" + std::string(key) + "\"");
+    }
+    return *value;
+}
+
+const JsonValue* JsonValue::find(std::string_view key) const {
+    if (type_ != JsonType::Object) {
+        return nullptr;
+    }
+    for (uint32_t i = 0; i < size_; ++i) {
+        if (members_[i].key.asString() == key) {
+            return &members_[i].value;
+        }
+    }
+    return nullptr;
+}
+
+// JsonDocument
+
+// Stage 2: recursive descent over the structural index built by stage 1.
+// Each position is a token start, so whitespace is never scanned again and
+// strings are found from their opening quote. Children are collected on
+// scratch stacks shared by the whole parse and moved into the arena as one
+// contiguous block when their container closes.
+struct JsonDocument::Parser {
+    JsonArena& arena;
+    const char* begin;
+    const char* end;
+    const char* p;
+    const uint32_t* positions;
+    size_t count;
+    size_t cursor = 0;
+    std::vector<JsonValue>& values;
+    std::vector<JsonMember>& members;
+    int depth = 0;
+    
+    static constexpr int kMaxDepth = 512;
+    
+    // Per-thread buffers reused across parses; fresh memory is far more
+    // expensive than the parse itself
+    struct Scratch {
+        std::vector<uint32_t> index;
+        std::vector<JsonValue> values;
+        std::vector<JsonMember> members;
+        
+        // Don't let one huge request pin its buffers on this thread forever
+        void trim() {
+            const size_t maxBytes = 4 * 1024 * 1024;
+            if (index.capacity() * sizeof(uint32_t) > maxBytes) {
+                std::vector<uint32_t>().swap(index);
+            }
+            if (values.capacity() * sizeof(JsonValue) > maxBytes) {
+                std::vector<JsonValue>().swap(values);
+            }
+            if (members.capacity() * sizeof(JsonMember) > maxBytes) {
+                std::vector<JsonMember>().swap(members);
+            }
+        }
+    };
+    
+    Parser(JsonArena& arena, const char* text, size_t size, Scratch& scratch)
+        : arena(arena), begin(text), end(text + size), p(text),
+          positions(scratch.index.data()), count(scratch.index.size()),
+          values(scratch.values), members(scratch.members) {
+        values.clear();
+        members.clear();
+    }
+    
+    [[noreturn]] void fail(const char* message) const {
+        throw std::runtime_error(std::string("Invalid JSON at offset ") +
+                                 std::to_string(p - begin) + ": " + message);
+    }
+    
+    // Move to the next token and return its first character
+    char advance() {
+        if (cursor >= count) {
+            p = end;
+            fail("unexpected end of input");
+        }
+        p = begin + positions[cursor++];
+        return *p;
+    }
+    
+    // Where the token after the current one starts (or the end of input)
+    const char* nextToken() const {
+        return cursor < count ? begin + positions[cursor] : end;
+    }
+    
+    static uint32_t checkedSize(size_t size) {
+        if (size > std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error("JSON value too large");
+        }
+        return static_cast<uint32_t>(size);
+    }
+    
+    JsonValue parseValue() {
+        switch (advance()) {
+            case '{': return parseObject();
+            case '[': return parseArray();
+            case '"': return parseString();
+            case 't': return parseLiteral("true", JsonType::Boolean, true);
+            case 'f': return parseLiteral("false", JsonType::Boolean, false);
+            case 'n': return parseLiteral("null", JsonType::Null, false);
+            default:
+                if (*p == '-' || (*p >= '0' && *p <= '9')) {
+                    return parseNumber();
+                }
+                fail("unexpected character");
+        }
+    }
+    
+    // A scalar must run right up to whitespace, an operator or the end
+    void endScalar(const char* scalarEnd) {
+        p = scalarEnd;
+        if (p < end) {
+            switch (*p) {
+                case ' ': case '\t': case '\n': case '\r':
+                case ',': case ':': case ']': case '}':
+                    break;
+                default:
+                    fail("unexpected character after value");
+            }
+        }
+    }
+    
+    JsonValue parseLiteral(const char* literal, JsonType type, bool boolean) {
+        size_t length = std::strlen(literal);
+        if (static_cast<size_t>(end - p) < length || std::memcmp(p, literal, length) != 0) {
+            fail("invalid literal");
+        }
+        endScalar(p + length);
+        JsonValue value;
+        value.type_ = type;
+        value.boolean_ = boolean;
+        return value;
+    }
+    
+    void enter() {
+        if (++depth > kMaxDepth) {
+            fail("nesting too deep");
+        }
+    }
+    
+    JsonValue parseObject() {
+        enter();
+        size_t mark = members.size();
+        
+        if (cursor < count && *nextToken() == '}') {
+            advance();
+        } else {
+            while (true) {
+                if (advance() != '"') {
+                    fail("expected object key");
+                }
+                JsonMember member;
+                member.key = parseString();
+                if (advance() != ':') {
+                    fail("expected ':' after object key");
+                }
+                member.value = parseValue();
+                members.push_back(member);
+                
+                char c = advance();
+                if (c == ',') {
+                    continue;
+                }
+                if (c == '}') {
+                    break;
+                }
+                fail("expected ',' or '}'");
+            }
+        }
+        
+        JsonValue value;
+        value.type_ = JsonType::Object;
+        value.size_ = checkedSize(members.size() - mark);
+        JsonMember* block = arena.allocateArray<JsonMember>(value.size_);
+        std::copy(members.begin() + mark, members.end(), block);
+        value.members_ = block;
+        members.resize(mark);
+        --depth;
+        return value;
+    }
+    
+    JsonValue parseArray() {
+        enter();
+        size_t mark = values.size();
+        
+        if (cursor < count && *nextToken() == ']') {
+            advance();
+        } else {
+            while (true) {
+                JsonValue element = parseValue();
+                values.push_back(element);
+                
+                char c = advance();
+                if (c == ',') {
+                    continue;
+                }
+                if (c == ']') {
+                    break;
+                }
+                fail("expected ',' or ']'");
+            }
+        }
+        
+        JsonValue value;
+        value.type_ = JsonType::Array;
+        value.size_ = checkedSize(values.size() - mark);
+        JsonValue* block = arena.allocateArray<JsonValue>(value.size_);
+        std::copy(values.begin() + mark, values.end(), block);
+        value.items_ = block;
+        values.resize(mark);
+        --depth;
+        return value;
+    }
+    
+    // First '"', '\\' or control character at or after from. The arena copy
+    // is padded with quotes, so 16-byte loads never leave it.
+    static const char* findStringSpecial(const char* from) {
+#if defined(__x86_64__) || defined(_M_X64)
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i control = _mm_set1_epi8(0x1F);
+        while (true) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from));
+            __m128i special = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+                _mm_cmpeq_epi8(_mm_min_epu8(v, control), v));
+            int mask = _mm_movemask_epi8(special);
+            if (mask != 0) {
+#if defined(_MSC_VER) && !defined(__clang__)
+                unsigned long index;
+                _BitScanForward(&index, static_cast<unsigned long>(mask));
+                return from + index;
+#else
+                return from + __builtin_ctz(static_cast<unsigned>(mask));
+#endif
+            }
+            from += 16;
+        }
+#else
+        while (*from != '"' && *from != '\\' && static_cast<unsigned char>(*from) >= 0x20) {
+            ++from;
+        }
+        return from;
+#endif
+    }
+    
+    static int hexDigit(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+    
+    unsigned parseHex4() {
+        if (end - p < 4) {
+            fail("truncated \\u escape");
+        }
+        unsigned code = 0;
+        for (int i = 0; i < 4; ++i) {
+            int digit = hexDigit(p[i]);
+            if (digit < 0) {
+                fail("invalid \\u escape");
+            }
+            code = (code << 4) | static_cast<unsigned>(digit);
+        }
+        p += 4;
+        return code;
+    }
+    
+    static char* appendUtf8(char* out, unsigned code) {
+        if (code < 0x80) {
+            *out++ = static_cast<char>(code);
+        } else if (code < 0x800) {
+            *out++ = static_cast<char>(0xC0 | (code >> 6));
+            *out++ = static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            *out++ = static_cast<char>(0xE0 | (code >> 12));
+            *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            *out++ = static_cast<char>(0xF0 | (code >> 18));
+            *out++ = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (code & 0x3F));
+        }
+        return out;
+    }
+    
+    JsonValue makeString(const char* data, size_t size) {
+        JsonValue value;
+        value.type_ = JsonType::String;
+        value.size_ = checkedSize(size);
+        if (size <= JsonValue::kInlineCapacity) {
+            value.flags_ = JsonValue::kInline;
+            std::memcpy(value.inline_, data, size);
+        } else {
+            value.chars_ = data;
+        }
+        return value;
+    }
+    
+    JsonValue parseString() {
+        ++p; // Skip '"'
+        const char* start = p;
+        
+        // Common case: no escapes, so the string is a view of the input copy
+        p = findStringSpecial(p);
+        if (p >= end) {
+            fail("unterminated string");
+        }
+        if (*p == '"') {
+            ++p;
+            return makeString(start, static_cast<size_t>(p - 1 - start));
+        }
+        
+        // Escapes only ever shrink the text, and the closing quote comes
+        // before the next token
+        char* out = arena.allocateArray<char>(static_cast<size_t>(nextToken() - start));
+        char* decoded = out;
+        
+        while (true) {
+            // Copy the plain run before p, then handle the byte at p
+            std::memcpy(out, start, static_cast<size_t>(p - start));
+            out += p - start;
+            
+            if (p >= end) {
+                fail("unterminated string");
+            }
+            char c = *p;
+            if (c == '"') {
+                ++p;
+                break;
+            }
+            if (c != '\\') {
+                fail("control character in string");
+            }
+            
+            ++p;
+            if (p >= end) {
+                fail("unterminated string");
+            }
+            char escape = *p++;
+            switch (escape) {
+                case '"': *out++ = '"'; break;
+                case '\\': *out++ = '\\'; break;
+                case '/': *out++ = '/'; break;
+                case 'b': *out++ = '\b'; break;
+                case 'f': *out++ = '\f'; break;
+                case 'n': *out++ = '\n'; break;
+                case 'r': *out++ = '\r'; break;
+                case 't': *out++ = '\t'; break;
+                case 'u': {
+                    unsigned code = parseHex4();
+                    if (code >= 0xD800 && code <= 0xDBFF) {
+                        // High surrogate: must pair with a low one
+                        if (end - p < 6 || p[0] != '\\' || p[1] != 'u') {
+                            fail("unpaired surrogate");
+                        }
+                        p += 2;
+                        unsigned low = parseHex4();
+                        if (low < 0xDC00 || low > 0xDFFF) {
+                            fail("unpaired surrogate");
+                        }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                        fail("unpaired surrogate");
+                    }
+                    out = appendUtf8(out, code);
+                    break;
+                }
+                default:
+                    fail("invalid escape");
+            }
+            
+            start = p;
+            p = findStringSpecial(p);
+        }
+        
+        return makeString(decoded, static_cast<size_t>(out - decoded));
+    }
+    
+    static double parseDouble(const char* first, const char* last) {
+        // strtod needs a terminated copy
+        char buffer[64];
+        std::string longNumber;
+        const char* text = buffer;
+        size_t length = static_cast<size_t>(last - first);
+        if (length < sizeof(buffer)) {
+            std::memcpy(buffer, first, length);
+            buffer[length] = '\0';
+        } else {
+            longNumber.assign(first, length);
+            text = longNumber.c_str();
+        }
+        return std::strtod(text, nullptr);
+    }
+    
+    JsonValue parseNumber() {
+        const char* start = p;
+        const char* q = p;
+        bool integral = true;
+        
+        auto isDigit = [&](const char* at) { return at < end && *at >= '0' && *at <= '9'; };
+        
+        if (*q == '-') {
+            ++q;
+        }
+        if (!isDigit(q)) {
+            fail("invalid number");
+        }
+        if (*q == '0') {
+            ++q;
+        } else {
+            while (isDigit(q)) {
+                ++q;
+            }
+        }
+        if (q < end && *q == '.') {
+            integral = false;
+            ++q;
+            if (!isDigit(q)) {
+                fail("invalid number");
+            }
+            while (isDigit(q)) {
+                ++q;
+            }
+        }
+        if (q < end && (*q == 'e' || *q == 'E')) {
+            integral = false;
+            ++q;
+            if (q < end && (*q == '+' || *q == '-')) {
+                ++q;
+            }
+            if (!isDigit(q)) {
+                fail("invalid number");
+            }
+            while (isDigit(q)) {
+                ++q;
+            }
+        }
+        
+        JsonValue value;
+        value.type_ = JsonType::Number;
+        
+        // Up to 18 digits always fit in int64 exactly; 19 digits fit up to
+        // INT64_MAX / INT64_MIN, which from_chars checks
+        const char* digits = start + (*start == '-' ? 1 : 0);
+        if (integral && q - digits <= 18) {
+            int64_t integer = 0;
+            for (const char* digit = digits; digit < q; ++digit) {
+                integer = integer * 10 + (*digit - '0');
+            }
+            value.integer_ = *start == '-' ? -integer : integer;
+            value.flags_ = JsonValue::kInteger;
+            endScalar(q);
+            return value;
+        }
+        if (integral && q - digits == 19) {
+            int64_t integer = 0;
+            if (std::from_chars(start, q, integer).ec == std::errc()) {
+                value.integer_ = integer;
+                value.flags_ = JsonValue::kInteger;
+                endScalar(q);
+                return value;
+            }
+        }
+        
+        // The grammar is already checked, so from_chars only converts.
+        // Out-of-range literals fall back to strtod's +-inf / 0.
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        if (std::from_chars(start, q, value.number_).ec != std::errc()) {
+            value.number_ = parseDouble(start, q);
+        }
+#else
+        value.number_ = parseDouble(start, q);
+#endif
+        endScalar(q);
+        return value;
+    }
+};
+
+JsonDocument::JsonDocument()
+    : arena_(256) {
+}
+
+JsonDocument JsonDocument::parse(std::string_view json, bool validateUtf8) {
+    if (validateUtf8 && !JsonString::isValidUtf8(json)) {
+        throw std::runtime_error("Invalid JSON: malformed UTF-8");
+    }
+    
+    JsonDocument document;
+    
+    // Stage 1: every token start, found 64 bytes at a time
+    static thread_local Parser::Scratch scratch;
+    JsonStructuralIndex::build(json.data(), json.size(), scratch.index);
+    
+    // Size one block for the whole document: the input copy, at most one
+    // member slot per token, and decoded strings (never longer than their
+    // source). The copy is padded with quotes so string scanning can read
+    // whole vectors past the end.
+    const size_t padding = 64;
+    document.arena_ = JsonArena(json.size() * 2 + padding +
+                                scratch.index.size() * sizeof(JsonMember) + 256);
+    char* text = document.arena_.allocateArray<char>(json.size() + padding);
+    std::memcpy(text, json.data(), json.size());
+    std::memset(text + json.size(), '"', padding);
+    
+    Parser parser(document.arena_, text, json.size(), scratch);
+    try {
+        document.root_ = parser.parseValue();
+        if (parser.cursor != parser.count) {
+            parser.advance();
+            parser.fail("trailing characters");
+        }
+    } catch (...) {
+        scratch.trim();
+        throw;
+    }
+    scratch.trim();
+    return document;
+}
+
+} // namespace httpapi 
@@ -0,0 +1,271 @@
+#include "httpapi/json_writer.hpp"
+#include "httpapi/json_string.hpp"
+#include "httpapi/thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace httpapi {
+
+namespace {
+
+// Elements serialized per chunk at minimum; below this the stitching copy
+// outweighs the parallelism
+const size_t kMinChunkSize = 256;
+
+// One parallelArray call, shared with the pool tasks so a task that starts
+// after the caller has returned finds nothing left to do and exits
+struct ParallelArrayJob {
+    ParallelArrayJob(const JsonWriter::ItemWriter& writeItem, size_t count, size_t chunkCount)
+        : writeItem(writeItem), count(count), chunks(chunkCount), next(0), done(0) {}
+    
+    // Claims and serializes chunks until none are left
+    void work() {
+        size_t chunkCount = chunks.size();
+        size_t index;
+        while ((index = next.fetch_add(1)) < chunkCount) {
+            try {
+                JsonWriter writer(chunks[index]);
+                writer.beginArray();
+                for (size_t i = count * index / chunkCount, end = count * (index + 1) / chunkCount;
+                     i < end; ++i) {
+                    writeItem(writer, i);
+                }
+                writer.endArray();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            
+            std::lock_guard<std::mutex> lock(mutex);
+            if (++done == chunkCount) {
+                finished.notify_all();
+            }
+        }
+    }
+    
+    const JsonWriter::ItemWriter& writeItem;
+    size_t count;
+    std::vector<std::string> chunks; // each one a complete "[...]"
+    std::atomic<size_t> next;
+    size_t done;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable finished;
+};
+
+} // namespace
+
+void JsonWriter::escape(std::string_view text, std::string& out) {
+    JsonString::escape(text, out);
+}
+
+void JsonWriter::prefix() {
+    if (afterKey_) {
+        afterKey_ = false;
+        return;
+    }
+    if (stack_.empty()) {
+        if (needComma_) {
+            throw std::runtime_error("JSON writer: document already complete");
+        }
+        return;
+    }
+    if (stack_.back() == '{') {
+        throw std::runtime_error("JSON writer: object value without a key");
+    }
+    if (needComma_) {
+        out_ += ',';
+    }
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    prefix();
+    out_ += '{';
+    stack_ += '{';
+    needComma_ = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    if (stack_.empty() || stack_.back() != '{' || afterKey_) {
+        throw std::runtime_error("JSON writer: unbalanced endObject");
+    }
+    out_ += '}';
+    stack_.pop_back();
+    needComma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    prefix();
+    out_ += '[';
+    stack_ += '[';
+    needComma_ = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    if (stack_.empty() || stack_.back() != '[') {
+        throw std::runtime_error("JSON writer: unbalanced endArray");
+    }
+    out_ += ']';
+    stack_.pop_back();
+    needComma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+    if (stack_.empty() || stack_.back() != '{' || afterKey_) {
+        throw std::runtime_error("JSON writer: key outside an object");
+    }
+    if (needComma_) {
+        out_ += ',';
+    }
+    out_ += '"';
+    escape(name, out_);
+    out_ += "\":";
+    needComma_ = true;
+    afterKey_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view text) {
+    prefix();
+    out_.reserve(out_.size() + text.size() + 2);
+    out_ += '"';
+    escape(text, out_);
+    out_ += '"';
+    needComma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+    prefix();
+    out_ += flag ? "true" : "false";
+    needComma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double number) {
+    if (!std::isfinite(number)) {
+        return null();
+    }
+    prefix();
+    char buffer[32];
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    // Shortest representation that round-trips
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+    out_.append(buffer, result.ptr - buffer);
+#else
+    int length = std::snprintf(buffer, sizeof(buffer), "%.17g", number);
+    out_.append(buffer, length);
+#endif
+    needComma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::writeInteger(int64_t number) {
+    prefix();
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+    out_.append(buffer, result.ptr - buffer);
+    needComma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::writeUnsigned(uint64_t number) {
+    prefix();
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+    out_.append(buffer, result.ptr - buffer);
+    needComma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    prefix();
+    out_ += "null";
+    needComma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::parallelArray(size_t count, const ItemWriter& writeItem) {
+    // Small arrays never start the shared pool
+    if (count < kParallelThreshold) {
+        return serialArray(count, writeItem);
+    }
+    return parallelArray(count, writeItem, ThreadPool::shared());
+}
+
+JsonWriter& JsonWriter::serialArray(size_t count, const ItemWriter& writeItem) {
+    beginArray();
+    for (size_t i = 0; i < count; ++i) {
+        writeItem(*this, i);
+    }
+    return endArray();
+}
+
+JsonWriter& JsonWriter::parallelArray(size_t count, const ItemWriter& writeItem, ThreadPool& pool) {
+    // One worker plus the caller rarely pays for the stitching copy
+    if (count < kParallelThreshold || pool.size() < 2) {
+        return serialArray(count, writeItem);
+    }
+    
+    // A few chunks per thread evens out elements of uneven size
+    size_t threads = pool.size() + 1;
+    size_t chunkCount = std::max<size_t>(1, std::min(threads * 4, count / kMinChunkSize));
+    auto job = std::make_shared<ParallelArrayJob>(writeItem, count, chunkCount);
+    for (size_t i = 1; i < std::min(threads, chunkCount); ++i) {
+        pool.submit([job]() { job->work(); });
+    }
+    job->work();
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(job->mutex);
+        job->finished.wait(lock, [&]() { return job->done == chunkCount; });
+        // Take the exception out so a pool thread dropping the last job
+        // reference never destroys it
+        error = std::move(job->error);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    
+    // Stitch the chunks' contents together in order
+    prefix();
+    size_t total = 2;
+    for (const auto& chunk : job->chunks) {
+        total += chunk.size() - 1;
+    }
+    out_.reserve(out_.size() + total);
+    out_ += '[';
+    for (size_t i = 0; i < chunkCount; ++i) {
+        if (i > 0) {
+            out_ += ',';
+        }
+        out_.append(job->chunks[i], 1, job->chunks[i].size() - 2);
+    }
+    out_ += ']';
+    needComma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::raw(std::string_view json) {
+    prefix();
+    out_.append(json.data(), json.size());
+    needComma_ = true;
+    return *this;
+}
+
+} // namespace httpapi 
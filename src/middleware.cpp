@@ -4,6 +4,58 @@
 
 namespace httpapi {
 
+// Walks a flattened middleware list by index. The `next` handed to each
+// middleware only carries a pointer to the runner, so it fits in
+// std::function's inline storage and the whole chain runs without allocating.
+template<typename Terminal>
+class ChainRunner {
+public:
+    ChainRunner(const Middleware& middleware, const Middleware::Chain* chain,
+                Request& req, Response& res, const Terminal& terminal)
+        : middleware_(middleware), chain_(chain), req_(req), res_(res),
+          terminal_(terminal), index_(0) {}
+    
+    void advance() {
+        const auto& entries = middleware_.middlewareChain_;
+        
+        if (chain_) {
+            while (index_ < chain_->steps.size()) {
+                const auto& step = chain_->steps[index_++];
+                const auto& entry = entries[step.index];
+                if (step.checkPath && !Middleware::pathMatches(entry.path, req_.path)) {
+                    continue;
+                }
+                entry.function(req_, res_, Next{this});
+                return;
+            }
+        } else {
+            while (index_ < entries.size()) {
+                const auto& entry = entries[index_++];
+                if (!Middleware::pathMatches(entry.path, req_.path)) {
+                    continue;
+                }
+                entry.function(req_, res_, Next{this});
+                return;
+            }
+        }
+        
+        terminal_();
+    }
+    
+private:
+    struct Next {
+        ChainRunner* runner;
+        void operator()() const { runner->advance(); }
+    };
+    
+    const Middleware& middleware_;
+    const Middleware::Chain* chain_;
+    Request& req_;
+    Response& res_;
+    const Terminal& terminal_;
+    size_t index_;
+};
+
 Middleware::Middleware() {
 }
 
@@ -18,13 +70,48 @@ void Middleware::use(const std::string& path, MiddlewareFunction middleware) {
     middlewareChain_.emplace_back(path, middleware);
 }
 
-void Middleware::execute(Request& req, Response& res, std::function<void()> next) {
-    if (middlewareChain_.empty()) {
-        next();
-        return;
-    }
+Middleware::Chain Middleware::compile(const std::string& routePath) const {
+    // Only the part of the route before its first parameter is known ahead
+    // of time; prefixes reaching past it are checked per request
+    size_t paramPos = routePath.find(':');
+    std::string literal = routePath.substr(0, paramPos);
+    bool hasParams = paramPos != std::string::npos;
     
-    executeNext(req, res, middlewareChain_.begin(), next);
+    Chain chain;
+    for (size_t i = 0; i < middlewareChain_.size(); ++i) {
+        const std::string& prefix = middlewareChain_[i].path;
+        uint32_t index = static_cast<uint32_t>(i);
+        
+        if (prefix.empty()) {
+            chain.steps.push_back({index, false});
+        } else if (prefix.size() <= literal.size() || !hasParams) {
+            if (pathMatches(prefix, literal)) {
+                chain.steps.push_back({index, false});
+            }
+        } else if (pathMatches(literal, prefix)) {
+            chain.steps.push_back({index, true});
+        }
+    }
+    return chain;
+}
+
+void Middleware::execute(Request& req, Response& res, std::function<void()> next) {
+    auto terminal = [&next]() { next(); };
+    ChainRunner<decltype(terminal)> runner(*this, nullptr, req, res, terminal);
+    runner.advance();
+}
+
+void Middleware::execute(Request& req, Response& res, const Handler& handler) const {
+    auto terminal = [&]() { handler(req, res); };
+    ChainRunner<decltype(terminal)> runner(*this, nullptr, req, res, terminal);
+    runner.advance();
+}
+
+void Middleware::execute(const Chain& chain, Request& req, Response& res, 
+                         const Handler& handler) const {
+    auto terminal = [&]() { handler(req, res); };
+    ChainRunner<decltype(terminal)> runner(*this, &chain, req, res, terminal);
+    runner.advance();
 }
 
 void Middleware::clear() {
@@ -40,28 +127,8 @@ bool Middleware::pathMatches(const std::string& middlewarePath, const std::strin
         return true; // Global middleware
     }
     
-    // Simple path matching - can be enhanced with regex
-    return requestPath.find(middlewarePath) == 0;
-}
-
-void Middleware::executeNext(Request& req, Response& res, 
-                           std::vector<MiddlewareEntry>::iterator current,
-                           std::function<void()> finalNext) {
-    if (current == middlewareChain_.end()) {
-        finalNext();
-        return;
-    }
-    
-    auto& entry = *current;
-    auto next = [this, &req, &res, current, finalNext]() mutable {
-        executeNext(req, res, ++current, finalNext);
-    };
-    
-    if (pathMatches(entry.path, req.path)) {
-        entry.function(req, res, next);
-    } else {
-        next();
-    }
+    // Simple prefix matching - can be enhanced with regex
+    return requestPath.compare(0, middlewarePath.size(), middlewarePath) == 0;
 }
 
-} // namespace httpapi 
\ No newline at end of file
+} // namespace httpapi 
@@ -0,0 +1,744 @@
+#include "httpapi/payload.hpp"
+#include "httpapi/json_handler.hpp"
+#include "httpapi/request.hpp"
+#include "httpapi/response.hpp"
+#include "httpapi/utils.hpp"
+#include <stdexcept>
+#include <typeinfo>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace httpapi {
+
+namespace {
+
+using JsonObject = std::unordered_map<std::string, std::any>;
+
+const int kMaxDepth = 64;
+
+void putBigEndian(std::string& out, uint64_t value, int bytes) {
+    for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+        out += static_cast<char>((value >> shift) & 0xff);
+    }
+}
+
+uint32_t floatBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+uint64_t doubleBits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Whether a double survives a round trip through float32
+bool fitsFloat(double value) {
+    return std::isnan(value) || static_cast<double>(static_cast<float>(value)) == value;
+}
+
+class MessagePackEncoder {
+public:
+    explicit MessagePackEncoder(std::string& out) : out_(out) {}
+    
+    void nil() { out_ += '\xc0'; }
+    void boolean(bool value) { out_ += value ? '\xc3' : '\xc2'; }
+    
+    void integer(int64_t value) {
+        if (value >= 0) {
+            unsignedInteger(static_cast<uint64_t>(value));
+        } else if (value >= -32) {
+            out_ += static_cast<char>(value); // negative fixint
+        } else if (value >= std::numeric_limits<int8_t>::min()) {
+            typed('\xd0', static_cast<uint64_t>(value), 1);
+        } else if (value >= std::numeric_limits<int16_t>::min()) {
+            typed('\xd1', static_cast<uint64_t>(value), 2);
+        } else if (value >= std::numeric_limits<int32_t>::min()) {
+            typed('\xd2', static_cast<uint64_t>(value), 4);
+        } else {
+            typed('\xd3', static_cast<uint64_t>(value), 8);
+        }
+    }
+    
+    void unsignedInteger(uint64_t value) {
+        if (value < 0x80) {
+            out_ += static_cast<char>(value); // positive fixint
+        } else if (value <= 0xff) {
+            typed('\xcc', value, 1);
+        } else if (value <= 0xffff) {
+            typed('\xcd', value, 2);
+        } else if (value <= 0xffffffff) {
+            typed('\xce', value, 4);
+        } else {
+            typed('\xcf', value, 8);
+        }
+    }
+    
+    void real(double value) {
+        if (fitsFloat(value)) {
+            typed('\xca', floatBits(static_cast<float>(value)), 4);
+        } else {
+            typed('\xcb', doubleBits(value), 8);
+        }
+    }
+    
+    void string(std::string_view value) {
+        if (value.size() < 32) {
+            out_ += static_cast<char>(0xa0 | value.size());
+        } else {
+            sized('\xd9', value.size());
+        }
+        out_.append(value.data(), value.size());
+    }
+    
+    void array(size_t count) {
+        if (count < 16) {
+            out_ += static_cast<char>(0x90 | count);
+        } else {
+            sized('\xdc', count, false);
+        }
+    }
+    
+    void map(size_t count) {
+        if (count < 16) {
+            out_ += static_cast<char>(0x80 | count);
+        } else {
+            sized('\xde', count, false);
+        }
+    }
+    
+private:
+    void typed(char type, uint64_t value, int bytes) {
+        out_ += type;
+        putBigEndian(out_, value, bytes);
+    }
+    
+    // str 8/16/32 and array/map 16/32 are consecutive type bytes; containers
+    // have no 8-bit form
+    void sized(char first, size_t size, bool hasByteForm = true) {
+        if (hasByteForm && size <= 0xff) {
+            typed(first, size, 1);
+        } else if (size <= 0xffff) {
+            typed(static_cast<char>(first + (hasByteForm ? 1 : 0)), size, 2);
+        } else {
+            typed(static_cast<char>(first + (hasByteForm ? 2 : 1)), size, 4);
+        }
+    }
+    
+    std::string& out_;
+};
+
+class CborEncoder {
+public:
+    explicit CborEncoder(std::string& out) : out_(out) {}
+    
+    void nil() { out_ += '\xf6'; }
+    void boolean(bool value) { out_ += value ? '\xf5' : '\xf4'; }
+    
+    void integer(int64_t value) {
+        if (value >= 0) {
+            head(0, static_cast<uint64_t>(value));
+        } else {
+            head(1, static_cast<uint64_t>(-(value + 1)));
+        }
+    }
+    
+    void unsignedInteger(uint64_t value) { head(0, value); }
+    
+    void real(double value) {
+        if (fitsFloat(value)) {
+            out_ += '\xfa';
+            putBigEndian(out_, floatBits(static_cast<float>(value)), 4);
+        } else {
+            out_ += '\xfb';
+            putBigEndian(out_, doubleBits(value), 8);
+        }
+    }
+    
+    void string(std::string_view value) {
+        head(3, value.size());
+        out_.append(value.data(), value.size());
+    }
+    
+    void array(size_t count) { head(4, count); }
+    void map(size_t count) { head(5, count); }
+    
+private:
+    // Major type in the top three bits, the argument inline below 24 or in
+    // the following 1, 2, 4 or 8 bytes
+    void head(int major, uint64_t argument) {
+        char type = static_cast<char>(major << 5);
+        if (argument < 24) {
+            out_ += static_cast<char>(type | argument);
+        } else if (argument <= 0xff) {
+            out_ += static_cast<char>(type | 24);
+            putBigEndian(out_, argument, 1);
+        } else if (argument <= 0xffff) {
+            out_ += static_cast<char>(type | 25);
+            putBigEndian(out_, argument, 2);
+        } else if (argument <= 0xffffffff) {
+            out_ += static_cast<char>(type | 26);
+            putBigEndian(out_, argument, 4);
+        } else {
+            out_ += static_cast<char>(type | 27);
+            putBigEndian(out_, argument, 8);
+        }
+    }
+    
+    std::string& out_;
+};
+
+// Same value types as JsonHandler::stringify
+template<typename Encoder>
+void encodeAny(Encoder& out, const std::any& value) {
+    const std::type_info& type = value.type();
+    if (type == typeid(std::string)) {
+        out.string(*std::any_cast<std::string>(&value));
+    } else if (type == typeid(const char*)) {
+        out.string(std::any_cast<const char*>(value));
+    } else if (type == typeid(int)) {
+        out.integer(std::any_cast<int>(value));
+    } else if (type == typeid(long)) {
+        out.integer(std::any_cast<long>(value));
+    } else if (type == typeid(long long)) {
+        out.integer(std::any_cast<long long>(value));
+    } else if (type == typeid(unsigned)) {
+        out.unsignedInteger(std::any_cast<unsigned>(value));
+    } else if (type == typeid(unsigned long)) {
+        out.unsignedInteger(std::any_cast<unsigned long>(value));
+    } else if (type == typeid(unsigned long long)) {
+        out.unsignedInteger(std::any_cast<unsigned long long>(value));
+    } else if (type == typeid(double)) {
+        out.real(std::any_cast<double>(value));
+    } else if (type == typeid(float)) {
+        out.real(std::any_cast<float>(value));
+    } else if (type == typeid(bool)) {
+        out.boolean(std::any_cast<bool>(value));
+    } else if (type == typeid(JsonObject)) {
+        const auto& object = *std::any_cast<JsonObject>(&value);
+        out.map(object.size());
+        for (const auto& pair : object) {
+            out.string(pair.first);
+            encodeAny(out, pair.second);
+        }
+    } else if (type == typeid(std::vector<std::any>)) {
+        const auto& items = *std::any_cast<std::vector<std::any>>(&value);
+        out.array(items.size());
+        for (const auto& item : items) {
+            encodeAny(out, item);
+        }
+    } else {
+        out.nil();
+    }
+}
+
+template<typename Encoder>
+std::string encodeObject(const JsonObject& data) {
+    std::string result;
+    Encoder encoder(result);
+    encoder.map(data.size());
+    for (const auto& pair : data) {
+        encoder.string(pair.first);
+        encodeAny(encoder, pair.second);
+    }
+    return result;
+}
+
+template<typename Encoder>
+std::string encodeArray(const std::vector<JsonObject>& array) {
+    std::string result;
+    Encoder encoder(result);
+    encoder.array(array.size());
+    for (const auto& object : array) {
+        encoder.map(object.size());
+        for (const auto& pair : object) {
+            encoder.string(pair.first);
+            encodeAny(encoder, pair.second);
+        }
+    }
+    return result;
+}
+
+// Bounds-checked reads over the input, shared by both decoders
+class ByteReader {
+public:
+    ByteReader(std::string_view data, const char* format)
+        : data_(data), pos_(0), format_(format) {}
+    
+    bool atEnd() const { return pos_ == data_.size(); }
+    size_t remaining() const { return data_.size() - pos_; }
+    
+    uint8_t peek() {
+        if (atEnd()) {
+            fail("unexpected end of input");
+        }
+        return static_cast<uint8_t>(data_[pos_]);
+    }
+    
+    uint8_t byte() {
+        uint8_t value = peek();
+        ++pos_;
+        return value;
+    }
+    
+    uint64_t bigEndian(int bytes) {
+        std::string_view raw = take(static_cast<size_t>(bytes));
+        uint64_t value = 0;
+        for (char c : raw) {
+            value = (value << 8) | static_cast<uint8_t>(c);
+        }
+        return value;
+    }
+    
+    std::string_view take(uint64_t size) {
+        if (size > remaining()) {
+            fail("unexpected end of input");
+        }
+        std::string_view result = data_.substr(pos_, static_cast<size_t>(size));
+        pos_ += static_cast<size_t>(size);
+        return result;
+    }
+    
+    [[noreturn]] void fail(const char* message) const {
+        throw std::runtime_error(std::string("Invalid ") + format_ + " at offset " +
+                                 std::to_string(pos_) + ": " + message);
+    }
+    
+private:
+    std::string_view data_;
+    size_t pos_;
+    const char* format_;
+};
+
+float toFloat(uint64_t bits) {
+    uint32_t narrow = static_cast<uint32_t>(bits);
+    float value;
+    std::memcpy(&value, &narrow, sizeof(value));
+    return value;
+}
+
+double toDouble(uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+std::any integerValue(uint64_t value) {
+    if (value <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+        return static_cast<int64_t>(value);
+    }
+    return value;
+}
+
+class MessagePackDecoder {
+public:
+    explicit MessagePackDecoder(std::string_view data) : in_(data, "MessagePack") {}
+    
+    JsonObject decode() {
+        if (in_.atEnd() || !isMap(in_.peek())) {
+            in_.fail("top-level value is not a map");
+        }
+        std::any root = value(0);
+        if (!in_.atEnd()) {
+            in_.fail("trailing bytes after the value");
+        }
+        return std::move(*std::any_cast<JsonObject>(&root));
+    }
+    
+private:
+    static bool isMap(uint8_t type) {
+        return (type & 0xf0) == 0x80 || type == 0xde || type == 0xdf;
+    }
+    
+    std::any value(int depth) {
+        uint8_t type = in_.byte();
+        if (type <= 0x7f) {
+            return static_cast<int64_t>(type);
+        }
+        if (type >= 0xe0) {
+            return static_cast<int64_t>(static_cast<int8_t>(type));
+        }
+        if ((type & 0xf0) == 0x80) {
+            return map(type & 0x0f, depth);
+        }
+        if ((type & 0xf0) == 0x90) {
+            return array(type & 0x0f, depth);
+        }
+        if ((type & 0xe0) == 0xa0) {
+            return std::string(in_.take(type & 0x1f));
+        }
+        
+        switch (type) {
+            case 0xc0: return std::any();
+            case 0xc2: return false;
+            case 0xc3: return true;
+            case 0xc4: case 0xd9: return std::string(in_.take(in_.bigEndian(1)));
+            case 0xc5: case 0xda: return std::string(in_.take(in_.bigEndian(2)));
+            case 0xc6: case 0xdb: return std::string(in_.take(in_.bigEndian(4)));
+            case 0xca: return static_cast<double>(toFloat(in_.bigEndian(4)));
+            case 0xcb: return toDouble(in_.bigEndian(8));
+            case 0xcc: return static_cast<int64_t>(in_.bigEndian(1));
+            case 0xcd: return static_cast<int64_t>(in_.bigEndian(2));
+            case 0xce: return static_cast<int64_t>(in_.bigEndian(4));
+            case 0xcf: return integerValue(in_.bigEndian(8));
+            case 0xd0: return static_cast<int64_t>(static_cast<int8_t>(in_.bigEndian(1)));
+            case 0xd1: return static_cast<int64_t>(static_cast<int16_t>(in_.bigEndian(2)));
+            case 0xd2: return static_cast<int64_t>(static_cast<int32_t>(in_.bigEndian(4)));
+            case 0xd3: return static_cast<int64_t>(in_.bigEndian(8));
+            case 0xdc: return array(in_.bigEndian(2), depth);
+            case 0xdd: return array(in_.bigEndian(4), depth);
+            case 0xde: return map(in_.bigEndian(2), depth);
+            case 0xdf: return map(in_.bigEndian(4), depth);
+            default: in_.fail("unsupported type");
+        }
+    }
+    
+    std::any array(uint64_t count, int depth) {
+        if (depth >= kMaxDepth) {
+            in_.fail("nesting too deep");
+        }
+        std::vector<std::any> items;
+        // Every element takes at least one byte, so a forged count cannot
+        // reserve more than the input could fill
+        items.reserve(static_cast<size_t>(std::min<uint64_t>(count, in_.remaining())));
+        for (uint64_t i = 0; i < count; ++i) {
+            items.push_back(value(depth + 1));
+        }
+        return items;
+    }
+    
+    std::any map(uint64_t count, int depth) {
+        if (depth >= kMaxDepth) {
+            in_.fail("nesting too deep");
+        }
+        JsonObject object;
+        for (uint64_t i = 0; i < count; ++i) {
+            std::any key = value(depth + 1);
+            if (key.type() != typeid(std::string)) {
+                in_.fail("map key is not a string");
+            }
+            object[std::move(*std::any_cast<std::string>(&key))] = value(depth + 1);
+        }
+        return object;
+    }
+    
+    ByteReader in_;
+};
+
+// IEEE 754 binary16, which CBOR encoders may use for small floats
+double halfToDouble(uint16_t half) {
+    int exponent = (half >> 10) & 0x1f;
+    int mantissa = half & 0x3ff;
+    double value;
+    if (exponent == 0) {
+        value = std::ldexp(mantissa, -24);
+    } else if (exponent != 31) {
+        value = std::ldexp(mantissa + 1024, exponent - 25);
+    } else {
+        value = mantissa == 0 ? std::numeric_limits<double>::infinity()
+                              : std::numeric_limits<double>::quiet_NaN();
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+class CborDecoder {
+public:
+    explicit CborDecoder(std::string_view data) : in_(data, "CBOR") {}
+    
+    JsonObject decode() {
+        if (in_.atEnd() || (in_.peek() >> 5) != 5) {
+            in_.fail("top-level value is not a map");
+        }
+        std::any root = value(0);
+        if (!in_.atEnd()) {
+            in_.fail("trailing bytes after the value");
+        }
+        return std::move(*std::any_cast<JsonObject>(&root));
+    }
+    
+private:
+    static constexpr uint8_t kBreak = 0xff;
+    static constexpr uint8_t kIndefinite = 31;
+    
+    uint64_t argument(uint8_t info) {
+        if (info < 24) {
+            return info;
+        }
+        switch (info) {
+            case 24: return in_.bigEndian(1);
+            case 25: return in_.bigEndian(2);
+            case 26: return in_.bigEndian(4);
+            case 27: return in_.bigEndian(8);
+            default: in_.fail("reserved additional information");
+        }
+    }
+    
+    std::any value(int depth) {
+        uint8_t initial = in_.byte();
+        int major = initial >> 5;
+        uint8_t info = initial & 0x1f;
+        
+        if (major == 7) {
+            switch (info) {
+                case 20: return false;
+                case 21: return true;
+                case 22: case 23: return std::any(); // null, undefined
+                case 25: return halfToDouble(static_cast<uint16_t>(in_.bigEndian(2)));
+                case 26: return static_cast<double>(toFloat(in_.bigEndian(4)));
+                case 27: return toDouble(in_.bigEndian(8));
+                default: in_.fail("unsupported simple value");
+            }
+        }
+        
+        if (info == kIndefinite) {
+            switch (major) {
+                case 2: case 3: return indefiniteString(major);
+                case 4: return array(0, true, depth);
+                case 5: return map(0, true, depth);
+                default: in_.fail("indefinite length on a type without one");
+            }
+        }
+        
+        uint64_t n = argument(info);
+        switch (major) {
+            case 0:
+                return integerValue(n);
+            case 1:
+                // -1 - n; beyond int64_t only a double can hold it
+                if (n <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+                    return -1 - static_cast<int64_t>(n);
+                }
+                return -1.0 - static_cast<double>(n);
+            case 2:
+            case 3:
+                return std::string(in_.take(n));
+            case 4:
+                return array(n, false, depth);
+            case 5:
+                return map(n, false, depth);
+            default:
+                // Tag: keep the tagged value, nesting counts towards the limit
+                if (depth >= kMaxDepth) {
+                    in_.fail("nesting too deep");
+                }
+                return value(depth + 1);
+        }
+    }
+    
+    // Definite-length chunks of the same major type up to a break
+    std::string indefiniteString(int major) {
+        std::string result;
+        while (in_.peek() != kBreak) {
+            uint8_t initial = in_.byte();
+            if ((initial >> 5) != major || (initial & 0x1f) == kIndefinite) {
+                in_.fail("invalid chunk in indefinite-length string");
+            }
+            std::string_view chunk = in_.take(argument(initial & 0x1f));
+            result.append(chunk.data(), chunk.size());
+        }
+        in_.byte();
+        return result;
+    }
+    
+    bool more(uint64_t& count, bool indefinite) {
+        if (indefinite) {
+            if (in_.peek() == kBreak) {
+                in_.byte();
+                return false;
+            }
+            return true;
+        }
+        return count-- > 0;
+    }
+    
+    std::any array(uint64_t count, bool indefinite, int depth) {
+        if (depth >= kMaxDepth) {
+            in_.fail("nesting too deep");
+        }
+        std::vector<std::any> items;
+        if (!indefinite) {
+            items.reserve(static_cast<size_t>(std::min<uint64_t>(count, in_.remaining())));
+        }
+        while (more(count, indefinite)) {
+            items.push_back(value(depth + 1));
+        }
+        return items;
+    }
+    
+    std::any map(uint64_t count, bool indefinite, int depth) {
+        if (depth >= kMaxDepth) {
+            in_.fail("nesting too deep");
+        }
+        JsonObject object;
+        while (more(count, indefinite)) {
+            std::any key = value(depth + 1);
+            if (key.type() != typeid(std::string)) {
+                in_.fail("map key is not a string");
+            }
+            object[std::move(*std::any_cast<std::string>(&key))] = value(depth + 1);
+        }
+        return object;
+    }
+    
+    ByteReader in_;
+};
+
+void addVary(Response& res, const std::string& header) {
+    std::string vary = res.get("Vary");
+    for (const auto& item : Utils::split(vary, ',')) {
+        if (Utils::toLowerCase(Utils::trim(item)) == Utils::toLowerCase(header)) {
+            return;
+        }
+    }
+    res.set("Vary", vary.empty() ? header : vary + ", " + header);
+}
+
+template<typename Data>
+void sendEncoded(const Request& req, Response& res, const Data& data) {
+    PayloadFormat format = Payload::negotiate(req.get("Accept"));
+    addVary(res, "Accept");
+    res.set("Content-Type", Payload::mediaType(format));
+    res.send(Payload::encode(data, format));
+}
+
+} // namespace
+
+std::string MessagePack::encode(const std::unordered_map<std::string, std::any>& data) {
+    return encodeObject<MessagePackEncoder>(data);
+}
+
+std::string MessagePack::encode(const std::vector<std::unordered_map<std::string, std::any>>& array) {
+    return encodeArray<MessagePackEncoder>(array);
+}
+
+std::unordered_map<std::string, std::any> MessagePack::decode(std::string_view data) {
+    return MessagePackDecoder(data).decode();
+}
+
+std::string Cbor::encode(const std::unordered_map<std::string, std::any>& data) {
+    return encodeObject<CborEncoder>(data);
+}
+
+std::string Cbor::encode(const std::vector<std::unordered_map<std::string, std::any>>& array) {
+    return encodeArray<CborEncoder>(array);
+}
+
+std::unordered_map<std::string, std::any> Cbor::decode(std::string_view data) {
+    return CborDecoder(data).decode();
+}
+
+PayloadFormat Payload::negotiate(const std::string& accept) {
+    if (accept.empty()) {
+        return PayloadFormat::Json;
+    }
+    
+    double weights[3] = {-1, -1, -1};
+    double wildcard = -1;
+    
+    for (const auto& item : Utils::split(accept, ',')) {
+        size_t semicolon = item.find(';');
+        std::string type = Utils::toLowerCase(Utils::trim(item.substr(0, semicolon)));
+        double q = 1.0;
+        if (semicolon != std::string::npos) {
+            for (const auto& param : Utils::split(item.substr(semicolon + 1), ';')) {
+                std::string trimmed = Utils::trim(param);
+                if (trimmed.compare(0, 2, "q=") == 0) {
+                    try {
+                        q = std::stod(trimmed.substr(2));
+                    } catch (...) {
+                        q = 0;
+                    }
+                }
+            }
+        }
+        
+        PayloadFormat format = formatOf(type);
+        if (format != PayloadFormat::Json || type == "application/json") {
+            weights[static_cast<int>(format)] = q;
+        } else if (type == "*/*" || type == "application/*") {
+            wildcard = q;
+        }
+    }
+    
+    // Wildcards only ever select JSON: clients that can read a binary
+    // format say so by name
+    if (weights[static_cast<int>(PayloadFormat::Json)] < 0) {
+        weights[static_cast<int>(PayloadFormat::Json)] = wildcard;
+    }
+    
+    PayloadFormat best = PayloadFormat::Json;
+    double bestWeight = 0;
+    for (PayloadFormat format : {PayloadFormat::MessagePack, PayloadFormat::Cbor, PayloadFormat::Json}) {
+        double weight = weights[static_cast<int>(format)];
+        if (weight > bestWeight) {
+            best = format;
+            bestWeight = weight;
+        }
+    }
+    return best;
+}
+
+PayloadFormat Payload::formatOf(const std::string& contentType) {
+    std::string type = Utils::toLowerCase(Utils::trim(contentType.substr(0, contentType.find(';'))));
+    if (type == "application/msgpack" || type == "application/x-msgpack" ||
+        type == "application/vnd.msgpack") {
+        return PayloadFormat::MessagePack;
+    }
+    if (type == "application/cbor") {
+        return PayloadFormat::Cbor;
+    }
+    return PayloadFormat::Json;
+}
+
+const char* Payload::mediaType(PayloadFormat format) {
+    switch (format) {
+        case PayloadFormat::MessagePack: return "application/msgpack";
+        case PayloadFormat::Cbor: return "application/cbor";
+        default: return "application/json";
+    }
+}
+
+std::string Payload::encode(const std::unordered_map<std::string, std::any>& data, PayloadFormat format) {
+    switch (format) {
+        case PayloadFormat::MessagePack: return MessagePack::encode(data);
+        case PayloadFormat::Cbor: return Cbor::encode(data);
+        default: return JsonHandler::stringify(data);
+    }
+}
+
+std::string Payload::encode(const std::vector<std::unordered_map<std::string, std::any>>& array,
+                            PayloadFormat format) {
+    switch (format) {
+        case PayloadFormat::MessagePack: return MessagePack::encode(array);
+        case PayloadFormat::Cbor: return Cbor::encode(array);
+        default: return JsonHandler::stringify(array);
+    }
+}
+
+std::unordered_map<std::string, std::any> Payload::decode(std::string_view body, PayloadFormat format) {
+    switch (format) {
+        case PayloadFormat::MessagePack: return MessagePack::decode(body);
+        case PayloadFormat::Cbor: return Cbor::decode(body);
+        default: return JsonHandler::parse(std::string(body));
+    }
+}
+
+std::unordered_map<std::string, std::any> Payload::parse(const Request& req) {
+    return decode(req.body, formatOf(req.getContentType()));
+}
+
+void Payload::send(const Request& req, Response& res, const std::unordered_map<std::string, std::any>& data) {
+    sendEncoded(req, res, data);
+}
+
+void Payload::send(const Request& req, Response& res,
+                   const std::vector<std::unordered_map<std::string, std::any>>& array) {
+    sendEncoded(req, res, array);
+}
+
+} // namespace httpapi 
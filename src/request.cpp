@@ -9,9 +9,18 @@ Request::Request() {
     // Initialize default values
 }
 
+void Request::rewrite(std::string newPath) {
+    path = std::move(newPath);
+    ++rewrites_;
+}
+
+void Request::rewrite(std::string newMethod, std::string newPath) {
+    method = std::move(newMethod);
+    rewrite(std::move(newPath));
+}
+
 std::string Request::get(const std::string& header) const {
-    auto it = headers.find(Utils::normalizeHeaderName(header));
-    return (it != headers.end()) ? it->second : "";
+    return headers.get(header);
 }
 
 std::string Request::param(const std::string& name) const {
@@ -20,69 +29,64 @@ std::string Request::param(const std::string& name) const {
 }
 
 std::string Request::query(const std::string& name) const {
-    auto it = queryParams.find(name);
-    return (it != queryParams.end()) ? it->second : "";
+    auto value = queryFields_.find(queryString, name);
+    return value ? std::string(*value) : "";
 }
 
-bool Request::is(const std::string& type) const {
-    std::string contentType = getContentType();
-    return contentType.find(type) != std::string::npos;
+std::vector<std::string_view> Request::queryAll(const std::string& name) const {
+    return queryFields_.findAll(queryString, name);
 }
 
-std::string Request::getContentType() const {
-    return get("content-type");
+std::string Request::form(const std::string& name) const {
+    if (!isForm()) {
+        return "";
+    }
+    auto value = formFields_.find(body, name);
+    return value ? std::string(*value) : "";
 }
 
-size_t Request::getContentLength() const {
-    std::string contentLength = get("content-length");
-    return contentLength.empty() ? 0 : std::stoul(contentLength);
+std::vector<std::string_view> Request::formAll(const std::string& name) const {
+    if (!isForm()) {
+        return {};
+    }
+    return formFields_.findAll(body, name);
 }
 
-void Request::setParam(const std::string& name, const std::string& value) {
-    params[name] = value;
+bool Request::isForm() const {
+    return is("application/x-www-form-urlencoded");
 }
 
-void Request::setQueryParam(const std::string& name, const std::string& value) {
-    queryParams[name] = value;
+JsonSlice Request::jsonPointer(std::string_view pointer) const {
+    return jsonPointers_.find(body, pointer);
 }
 
-void Request::parseQueryString() {
-    if (queryString.empty()) {
-        return;
-    }
+void Request::setQueryString(std::string newQueryString) {
+    queryString = std::move(newQueryString);
+    queryFields_.clear();
+}
 
-    std::vector<std::string> pairs = Utils::split(queryString, '&');
-    for (const auto& pair : pairs) {
-        size_t equalPos = pair.find('=');
-        if (equalPos != std::string::npos) {
-            std::string name = Utils::urlDecode(pair.substr(0, equalPos));
-            std::string value = Utils::urlDecode(pair.substr(equalPos + 1));
-            queryParams[name] = value;
-        }
-    }
+void Request::setBody(std::string newBody) {
+    body = std::move(newBody);
+    jsonPointers_.clear();
+    formFields_.clear();
 }
 
-void Request::parseBody() {
-    // This is a basic implementation
-    // In a real framework, you'd want to handle different content types
-    // like application/json, application/x-www-form-urlencoded, etc.
-    
+bool Request::is(const std::string& type) const {
     std::string contentType = getContentType();
-    if (contentType.find("application/json") != std::string::npos) {
-        // Parse JSON body
-        // This would be implemented with a JSON parser
-    } else if (contentType.find("application/x-www-form-urlencoded") != std::string::npos) {
-        // Parse form data
-        std::vector<std::string> pairs = Utils::split(body, '&');
-        for (const auto& pair : pairs) {
-            size_t equalPos = pair.find('=');
-            if (equalPos != std::string::npos) {
-                std::string name = Utils::urlDecode(pair.substr(0, equalPos));
-                std::string value = Utils::urlDecode(pair.substr(equalPos + 1));
-                params[name] = value;
-            }
-        }
-    }
+    return contentType.find(type) != std::string::npos;
+}
+
+std::string Request::getContentType() const {
+    return headers.get(HeaderId::ContentType);
+}
+
+size_t Request::getContentLength() const {
+    std::string contentLength = headers.get(HeaderId::ContentLength);
+    return contentLength.empty() ? 0 : std::stoul(contentLength);
+}
+
+void Request::setParam(const std::string& name, const std::string& value) {
+    params[name] = value;
 }
 
 } // namespace httpapi 
\ No newline at end of file
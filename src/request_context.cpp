@@ -0,0 +1,134 @@
+#include "httpapi/request_context.hpp"
+#include <atomic>
+
+namespace httpapi {
+
+size_t RequestContext::nextKey() {
+    static std::atomic<size_t> next{0};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+RequestContext::RequestContext(const RequestContext& other) {
+    try {
+        copyFrom(other);
+    } catch (...) {
+        // No destructor runs for a constructor that throws
+        clear();
+        throw;
+    }
+}
+
+RequestContext::RequestContext(RequestContext&& other) {
+    try {
+        moveFrom(other);
+    } catch (...) {
+        clear();
+        throw;
+    }
+}
+
+RequestContext& RequestContext::operator=(const RequestContext& other) {
+    if (this != &other) {
+        clear();
+        copyFrom(other);
+    }
+    return *this;
+}
+
+RequestContext& RequestContext::operator=(RequestContext&& other) {
+    if (this != &other) {
+        clear();
+        moveFrom(other);
+    }
+    return *this;
+}
+
+RequestContext::~RequestContext() {
+    clear();
+}
+
+void RequestContext::clear() {
+    for (Slot& slot : slots_) {
+        reset(slot);
+    }
+    for (Slot& slot : overflow_) {
+        reset(slot);
+    }
+    overflow_.clear();
+    used_ = 0;
+}
+
+const RequestContext::Slot* RequestContext::slotAt(size_t index) const {
+    if (index < kInlineSlots) {
+        return &slots_[index];
+    }
+    index -= kInlineSlots;
+    return index < overflow_.size() ? &overflow_[index] : nullptr;
+}
+
+RequestContext::Slot* RequestContext::mutableSlotAt(size_t index) {
+    return const_cast<Slot*>(static_cast<const RequestContext*>(this)->slotAt(index));
+}
+
+RequestContext::Slot& RequestContext::slotFor(size_t index) {
+    if (index < kInlineSlots) {
+        return slots_[index];
+    }
+    index -= kInlineSlots;
+    if (index >= overflow_.size()) {
+        overflow_.resize(index + 1);
+    }
+    return overflow_[index];
+}
+
+void* RequestContext::allocate(size_t size, size_t alignment, bool& heap) {
+    size_t offset = (used_ + alignment - 1) & ~(alignment - 1);
+    if (offset + size <= kInlineBytes) {
+        used_ = offset + size;
+        heap = false;
+        return buffer_ + offset;
+    }
+    heap = true;
+    return ::operator new(size);
+}
+
+void RequestContext::reset(Slot& slot) {
+    if (!slot.value) {
+        return;
+    }
+    // Inline space is reclaimed only by clear()
+    slot.ops->destroy(slot.value);
+    if (slot.heap) {
+        ::operator delete(slot.value);
+    }
+    slot = Slot();
+}
+
+void RequestContext::copyFrom(const RequestContext& other) {
+    for (size_t i = 0; i < kInlineSlots; ++i) {
+        if (other.slots_[i].value) {
+            other.slots_[i].ops->copy(other.slots_[i].value, *this, i);
+        }
+    }
+    for (size_t i = 0; i < other.overflow_.size(); ++i) {
+        if (other.overflow_[i].value) {
+            other.overflow_[i].ops->copy(other.overflow_[i].value, *this, kInlineSlots + i);
+        }
+    }
+}
+
+void RequestContext::moveFrom(RequestContext& other) {
+    for (size_t i = 0; i < kInlineSlots; ++i) {
+        if (other.slots_[i].value) {
+            other.slots_[i].ops->move(other.slots_[i].value, *this, i);
+        }
+    }
+    for (size_t i = 0; i < other.overflow_.size(); ++i) {
+        if (other.overflow_[i].value) {
+            other.overflow_[i].ops->move(other.overflow_[i].value, *this, kInlineSlots + i);
+        }
+    }
+    other.clear();
+}
+
+} // namespace httpapi 
@@ -2,6 +2,8 @@
 #include "httpapi/utils.hpp"
 #include <sstream>
 #include <fstream>
+#include <algorithm>
+#include <stdexcept>
 
 namespace httpapi {
 
@@ -17,7 +19,7 @@ Response& Response::status(int code) {
 }
 
 Response& Response::set(const std::string& field, const std::string& value) {
-    headers[Utils::normalizeHeaderName(field)] = value;
+    headers.set(field, value);
     return *this;
 }
 
@@ -25,31 +27,146 @@ Response& Response::header(const std::string& field, const std::string& value) {
     return set(field, value);
 }
 
+Response& Response::append(const std::string& field, const std::string& value) {
+    headers.add(field, value);
+    return *this;
+}
+
+std::string Response::get(const std::string& field) const {
+    return headers.get(field);
+}
+
 Response& Response::send(const std::string& data) {
     body = data;
+    dropStream();
+    region_.reset();
+    regionView_ = std::string_view();
     if (!headersSent_) {
-        set("Content-Length", std::to_string(data.length()));
+        headers.set(HeaderId::ContentLength, std::to_string(data.length()));
         headersSent_ = true;
     }
     ended_ = true;
     return *this;
 }
 
+Response& Response::send(std::shared_ptr<const FileRegion> region, size_t offset, size_t length) {
+    body.clear();
+    dropStream();
+    regionView_ = region ? region->view().substr(std::min(offset, region->size()), length) : std::string_view();
+    region_ = std::move(region);
+    headers.set(HeaderId::ContentLength, std::to_string(regionView_.size()));
+    headersSent_ = true;
+    ended_ = true;
+    return *this;
+}
+
+std::string_view Response::bodyView() const {
+    return region_ ? regionView_ : std::string_view(body);
+}
+
+void Response::dropStream() {
+    if (producer_) {
+        producer_ = nullptr;
+        headers.erase(HeaderId::TransferEncoding);
+        headersSent_ = false; // so the replacement body sets Content-Length
+    }
+}
+
+Response& Response::stream(StreamProducer producer) {
+    body.clear();
+    region_.reset();
+    regionView_ = std::string_view();
+    producer_ = std::move(producer);
+    headers.erase(HeaderId::ContentLength);
+    headers.set(HeaderId::TransferEncoding, "chunked");
+    headersSent_ = true;
+    ended_ = true;
+    return *this;
+}
+
+namespace {
+
+// Writes rows into `out` until the piece reaches the chunk size; returns
+// false once the generator has run dry. `separator` goes before every row
+// but the first, `terminator` after every row.
+bool writeRows(Response::RowGenerator& rows, std::string& out, bool& first,
+               std::string_view separator, std::string_view terminator) {
+    while (out.size() < Response::kStreamChunkSize) {
+        size_t mark = out.size();
+        if (!first) {
+            out.append(separator);
+        }
+        JsonWriter writer(out);
+        if (!rows(writer)) {
+            out.resize(mark);
+            return false;
+        }
+        if (!writer.complete()) {
+            throw std::runtime_error("Row generator did not write a complete JSON value");
+        }
+        out.append(terminator);
+        first = false;
+    }
+    return true;
+}
+
+} // namespace
+
+Response& Response::ndjson(RowGenerator rows) {
+    headers.set(HeaderId::ContentType, "application/x-ndjson");
+    return stream([rows = std::move(rows), first = true](std::string& out) mutable {
+        return writeRows(rows, out, first, "", "\n");
+    });
+}
+
+Response& Response::jsonArray(RowGenerator rows) {
+    headers.set(HeaderId::ContentType, "application/json");
+    return stream([rows = std::move(rows), first = true, opened = false](std::string& out) mutable {
+        if (!opened) {
+            out += '[';
+            opened = true;
+        }
+        if (writeRows(rows, out, first, ",", "")) {
+            return true;
+        }
+        out += ']';
+        return false;
+    });
+}
+
 Response& Response::json(const std::string& data) {
-    set("Content-Type", "application/json");
+    headers.set(HeaderId::ContentType, "application/json");
     return send(data);
 }
 
+std::string& Response::beginJson() {
+    headers.set(HeaderId::ContentType, "application/json");
+    body.clear();
+    dropStream();
+    region_.reset();
+    regionView_ = std::string_view();
+    return body;
+}
+
+Response& Response::endJson() {
+    if (!headersSent_) {
+        headers.set(HeaderId::ContentLength, std::to_string(body.length()));
+        headersSent_ = true;
+    }
+    ended_ = true;
+    return *this;
+}
+
 Response& Response::sendFile(const std::string& path) {
     std::ifstream file(path, std::ios::binary);
     if (!file.is_open()) {
         return status(404).send("File not found");
     }
-
+    
     std::stringstream buffer;
     buffer << file.rdbuf();
     std::string content = buffer.str();
-
+    
     // Set appropriate content type based on file extension
     std::string extension = Utils::getFileExtension(path);
     std::string mimeType = "text/plain"; // Default MIME type
@@ -66,14 +183,14 @@ Response& Response::sendFile(const std::string& path) {
     } else if (extension == "jpg" || extension == "jpeg") {
         mimeType = "image/jpeg";
     }
-    set("Content-Type", mimeType);
-
+    headers.set(HeaderId::ContentType, mimeType);
+    
     return send(content);
 }
 
 Response& Response::redirect(const std::string& url) {
     status(302);
-    set("Location", url);
+    headers.set(HeaderId::Location, url);
     return send("");
 }
 
@@ -110,25 +227,34 @@ Response& Response::internalServerError() {
 }
 
 std::string Response::toString() const {
-    std::ostringstream response;
+    std::string response = headerString();
+    response.append(bodyView());
+    return response;
+}
+
+std::string Response::headerString() const {
+    std::string response;
+    response.reserve(64 + headers.size() * 48);
     
     // Status line
-    response << "HTTP/1.1 " << statusCode << " " << statusMessage << "\r\n";
+    response += "HTTP/1.1 ";
+    response += std::to_string(statusCode);
+    response += ' ';
+    response += statusMessage;
+    response += "\r\n";
     
     // Headers
     for (const auto& header : headers) {
-        response << header.first << ": " << header.second << "\r\n";
+        response += header.name();
+        response += ": ";
+        response += header.value;
+        response += "\r\n";
     }
     
     // Empty line to separate headers from body
-    response << "\r\n";
-    
-    // Body
-    if (!body.empty()) {
-        response << body;
-    }
+    response += "\r\n";
     
-    return response.str();
+    return response;
 }
 
 void Response::clear() {
@@ -136,17 +262,20 @@ void Response::clear() {
     statusMessage = "OK";
     headers.clear();
     body.clear();
+    region_.reset();
+    regionView_ = std::string_view();
+    producer_ = nullptr;
     headersSent_ = false;
     ended_ = false;
     setDefaultHeaders();
 }
 
 void Response::setDefaultHeaders() {
-    if (headers.find("Content-Type") == headers.end()) {
-        set("Content-Type", "text/plain");
+    if (!headers.has(HeaderId::ContentType)) {
+        headers.set(HeaderId::ContentType, "text/plain");
     }
-    set("Server", "HttpApi/1.0");
-    set("Connection", "close");
+    headers.set(HeaderId::Server, "HttpApi/1.0");
+    headers.set(HeaderId::Connection, "close");
 }
 
 std::string Response::getStatusText(int code) const {
@@ -154,12 +283,15 @@ std::string Response::getStatusText(int code) const {
         case 200: return "OK";
         case 201: return "Created";
         case 204: return "No Content";
+        case 206: return "Partial Content";
         case 301: return "Moved Permanently";
         case 302: return "Found";
+        case 304: return "Not Modified";
         case 400: return "Bad Request";
         case 401: return "Unauthorized";
         case 403: return "Forbidden";
         case 404: return "Not Found";
+        case 416: return "Range Not Satisfiable";
         case 500: return "Internal Server Error";
         case 501: return "Not Implemented";
         case 502: return "Bad Gateway";
@@ -0,0 +1,345 @@
+#include "httpapi/response_cache.hpp"
+#include "httpapi/utils.hpp"
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace httpapi {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct CachedResponse {
+    int statusCode = 200;
+    std::string statusMessage;
+    Headers headers;
+    std::string body;
+    Clock::time_point storedAt;
+    Clock::time_point expires;
+    size_t size = 0;
+    
+    // Set on the entry stored under the primary key of a response carrying
+    // Vary; the actual responses live under primary key + header values
+    std::vector<std::string> vary;
+};
+
+struct Shard {
+    struct Slot {
+        std::shared_ptr<const CachedResponse> response;
+        std::list<std::string>::iterator position;
+    };
+    
+    std::mutex mutex;
+    std::list<std::string> lru;
+    std::unordered_map<std::string, Slot> entries;
+    size_t bytes = 0;
+};
+
+struct CacheDirectives {
+    bool noStore = false;
+    bool noCache = false;
+    bool isPrivate = false;
+    bool isPublic = false;
+    bool mustRevalidate = false;
+    long maxAge = -1;
+    long sMaxAge = -1;
+};
+
+CacheDirectives parseCacheControl(const std::string& value) {
+    CacheDirectives directives;
+    for (const auto& item : Utils::split(value, ',')) {
+        std::string directive = Utils::toLowerCase(Utils::trim(item));
+        size_t equals = directive.find('=');
+        std::string name = directive.substr(0, equals);
+        long seconds = -1;
+        if (equals != std::string::npos) {
+            try {
+                seconds = std::stol(directive.substr(equals + 1));
+            } catch (...) {
+                seconds = 0;
+            }
+        }
+        
+        if (name == "no-store") {
+            directives.noStore = true;
+        } else if (name == "no-cache") {
+            directives.noCache = true;
+        } else if (name == "private") {
+            directives.isPrivate = true;
+        } else if (name == "public") {
+            directives.isPublic = true;
+        } else if (name == "must-revalidate") {
+            directives.mustRevalidate = true;
+        } else if (name == "max-age") {
+            directives.maxAge = seconds;
+        } else if (name == "s-maxage") {
+            directives.sMaxAge = seconds;
+        }
+    }
+    return directives;
+}
+
+size_t entryCost(const std::string& key, const CachedResponse& response) {
+    size_t size = key.size() + response.body.size() + sizeof(CachedResponse);
+    for (const auto& header : response.headers) {
+        size += header.name().size() + header.value.size();
+    }
+    for (const auto& name : response.vary) {
+        size += name.size();
+    }
+    return size;
+}
+
+} // namespace
+
+struct ResponseCache::Impl {
+    ResponseCacheOptions options;
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t shardCapacity;
+    
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> stores{0};
+    std::atomic<uint64_t> evictions{0};
+    
+    explicit Impl(ResponseCacheOptions opts) : options(std::move(opts)) {
+        if (options.shards == 0) {
+            options.shards = 1;
+        }
+        for (size_t i = 0; i < options.shards; ++i) {
+            shards.push_back(std::make_unique<Shard>());
+        }
+        shardCapacity = options.maxBytes / options.shards;
+    }
+    
+    Shard& shardFor(const std::string& primaryKey) {
+        return *shards[std::hash<std::string>()(primaryKey) % shards.size()];
+    }
+    
+    std::string primaryKey(const Request& req) const {
+        std::string key = req.method + ' ' + req.path;
+        if (!options.queryKeys.empty()) {
+            for (const auto& name : options.queryKeys) {
+                key += '\n' + name + '=' + req.query(name);
+            }
+        } else if (options.includeQuery) {
+            key += '?' + req.queryString;
+        }
+        for (const auto& name : options.keyHeaders) {
+            key += '\n' + name + ':' + req.get(name);
+        }
+        return key;
+    }
+    
+    static std::string variantKey(const std::string& primaryKey, const std::vector<std::string>& vary,
+                                  const Request& req) {
+        std::string key = primaryKey + "\nvary";
+        for (const auto& name : vary) {
+            key += '\n' + req.get(name);
+        }
+        return key;
+    }
+    
+    // Caller holds shard.mutex
+    std::shared_ptr<const CachedResponse> find(Shard& shard, const std::string& key, Clock::time_point now) {
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end()) {
+            return nullptr;
+        }
+        if (it->second.response->expires <= now) {
+            erase(shard, it);
+            return nullptr;
+        }
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second.position);
+        return it->second.response;
+    }
+    
+    // Caller holds shard.mutex
+    void erase(Shard& shard, std::unordered_map<std::string, Shard::Slot>::iterator it) {
+        shard.bytes -= entryCost(it->first, *it->second.response);
+        shard.lru.erase(it->second.position);
+        shard.entries.erase(it);
+    }
+    
+    // Caller holds shard.mutex
+    void insert(Shard& shard, const std::string& key, std::shared_ptr<const CachedResponse> response) {
+        auto existing = shard.entries.find(key);
+        if (existing != shard.entries.end()) {
+            erase(shard, existing);
+        }
+        
+        shard.lru.push_front(key);
+        shard.bytes += response->size;
+        shard.entries[key] = {std::move(response), shard.lru.begin()};
+        
+        while (shard.bytes > shardCapacity && !shard.lru.empty()) {
+            erase(shard, shard.entries.find(shard.lru.back()));
+            evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    
+    std::shared_ptr<const CachedResponse> lookup(const std::string& primary, const Request& req) {
+        Shard& shard = shardFor(primary);
+        auto now = Clock::now();
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        
+        auto entry = find(shard, primary, now);
+        if (entry && !entry->vary.empty()) {
+            entry = find(shard, variantKey(primary, entry->vary, req), now);
+        }
+        return entry;
+    }
+    
+    bool keysOn(std::string_view header) const {
+        for (const auto& name : options.keyHeaders) {
+            if (Headers::equalsIgnoreCase(name, header)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    void store(const std::string& primary, const Request& req, const Response& res) {
+        // Streamed bodies are produced as they are sent and never held whole
+        if (res.statusCode != 200 || res.headers.has(HeaderId::SetCookie) || res.isStreaming()) {
+            return;
+        }
+        
+        CacheDirectives directives = parseCacheControl(res.headers.get(HeaderId::CacheControl));
+        if (directives.noStore || directives.noCache || directives.isPrivate) {
+            return;
+        }
+        
+        // Shared-cache rule (RFC 9111, 3.5): an authorized response is reused
+        // for other requests only when it says so, unless Authorization is
+        // part of the key and the entry can only ever match the same caller
+        if (req.headers.has(HeaderId::Authorization) && !keysOn("Authorization") &&
+            !directives.isPublic && directives.sMaxAge < 0 && !directives.mustRevalidate) {
+            return;
+        }
+        
+        long ttl = directives.sMaxAge >= 0 ? directives.sMaxAge
+                 : directives.maxAge >= 0 ? directives.maxAge
+                 : static_cast<long>(options.ttl.count());
+        if (ttl <= 0) {
+            return;
+        }
+        
+        std::vector<std::string> vary;
+        for (const auto& item : Utils::split(res.headers.get(HeaderId::Vary), ',')) {
+            std::string name = Utils::trim(item);
+            if (name == "*") {
+                return;
+            }
+            if (!name.empty()) {
+                vary.push_back(name);
+            }
+        }
+        
+        auto now = Clock::now();
+        auto expires = now + std::chrono::seconds(ttl);
+        
+        auto response = std::make_shared<CachedResponse>();
+        response->statusCode = res.statusCode;
+        response->statusMessage = res.statusMessage;
+        response->headers = res.headers;
+        // A region-backed body (send(region)) is copied out; `body` is empty
+        response->body = std::string(res.bodyView());
+        response->storedAt = now;
+        response->expires = expires;
+        
+        std::string key = vary.empty() ? primary : variantKey(primary, vary, req);
+        response->size = entryCost(key, *response);
+        if (response->size > shardCapacity) {
+            return;
+        }
+        
+        std::shared_ptr<CachedResponse> marker;
+        if (!vary.empty()) {
+            marker = std::make_shared<CachedResponse>();
+            marker->vary = vary;
+            marker->expires = expires;
+            marker->size = entryCost(primary, *marker);
+        }
+        
+        Shard& shard = shardFor(primary);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (marker) {
+            insert(shard, primary, std::move(marker));
+        }
+        insert(shard, key, std::move(response));
+        stores.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+ResponseCache::ResponseCache(ResponseCacheOptions options)
+    : impl_(std::make_shared<Impl>(std::move(options))) {
+}
+
+Middleware::MiddlewareFunction ResponseCache::middleware() const {
+    std::shared_ptr<Impl> impl = impl_;
+    return [impl](Request& req, Response& res, std::function<void()> next) {
+        if (req.method != "GET" && req.method != "HEAD") {
+            next();
+            return;
+        }
+        
+        CacheDirectives requested = parseCacheControl(req.get("Cache-Control"));
+        if (requested.noStore) {
+            next();
+            return;
+        }
+        
+        std::string primary = impl->primaryKey(req);
+        bool revalidate = requested.noCache || requested.maxAge == 0 ||
+                          Utils::toLowerCase(req.get("Pragma")) == "no-cache";
+        
+        if (!revalidate) {
+            if (auto cached = impl->lookup(primary, req)) {
+                impl->hits.fetch_add(1, std::memory_order_relaxed);
+                
+                res.statusCode = cached->statusCode;
+                res.statusMessage = cached->statusMessage;
+                res.headers.merge(cached->headers);
+                res.body = cached->body;
+                
+                auto age = std::chrono::duration_cast<std::chrono::seconds>(
+                    Clock::now() - cached->storedAt);
+                res.set("Age", std::to_string(age.count()));
+                return;
+            }
+        }
+        
+        impl->misses.fetch_add(1, std::memory_order_relaxed);
+        next();
+        impl->store(primary, req, res);
+    };
+}
+
+ResponseCacheStats ResponseCache::stats() const {
+    ResponseCacheStats stats;
+    stats.hits = impl_->hits.load();
+    stats.misses = impl_->misses.load();
+    stats.stores = impl_->stores.load();
+    stats.evictions = impl_->evictions.load();
+    
+    for (const auto& shard : impl_->shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.entries += shard->entries.size();
+        stats.bytes += shard->bytes;
+    }
+    return stats;
+}
+
+void ResponseCache::clear() {
+    for (const auto& shard : impl_->shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->entries.clear();
+        shard->lru.clear();
+        shard->bytes = 0;
+    }
+}
+
+} // namespace httpapi 
@@ -1,6 +1,7 @@
 #include "httpapi/router.hpp"
 #include "httpapi/utils.hpp"
 #include <iostream>
+#include <thread>
 
 namespace httpapi {
 
@@ -18,11 +19,14 @@ bool Route::matches(const std::string& requestMethod, const std::string& request
         return false;
     }
     
-    std::smatch match;
-    return std::regex_match(requestPath, match, regex);
+    return std::regex_match(requestPath, regex);
 }
 
 void Route::extractParams(const std::string& requestPath, Request& req) const {
+    if (paramNames.empty()) {
+        return;
+    }
+    
     std::smatch match;
     if (std::regex_match(requestPath, match, regex)) {
         for (size_t i = 1; i < match.size() && i - 1 < paramNames.size(); ++i) {
@@ -69,49 +73,229 @@ std::string Route::pathToRegex(const std::string& path, std::vector<std::string>
     return regex;
 }
 
-Router::Router() {
+Router::Router()
+    : table_(new RouteTable()), epoch_(0) {
 }
 
 Router::~Router() {
+    delete table_.load();
+}
+
+Router::ReadGuard::ReadGuard(const Router& router)
+    : router_(router) {
+    slot_ = router_.epoch_.load() & 1;
+    router_.readers_[slot_].value.fetch_add(1);
+    // Loaded after registering as a reader, so a writer that swaps the table
+    // afterwards waits for this guard before freeing what we see here
+    table_ = router_.table_.load();
+}
+
+Router::ReadGuard::~ReadGuard() {
+    router_.readers_[slot_].value.fetch_sub(1);
 }
 
 void Router::get(const std::string& path, std::function<void(Request&, Response&)> handler) {
-    routes_.push_back(std::make_unique<Route>("GET", path, handler));
+    addRoute("GET", path, handler);
 }
 
 void Router::post(const std::string& path, std::function<void(Request&, Response&)> handler) {
-    routes_.push_back(std::make_unique<Route>("POST", path, handler));
+    addRoute("POST", path, handler);
 }
 
 void Router::put(const std::string& path, std::function<void(Request&, Response&)> handler) {
-    routes_.push_back(std::make_unique<Route>("PUT", path, handler));
+    addRoute("PUT", path, handler);
 }
 
 void Router::delete_(const std::string& path, std::function<void(Request&, Response&)> handler) {
-    routes_.push_back(std::make_unique<Route>("DELETE", path, handler));
+    addRoute("DELETE", path, handler);
 }
 
 void Router::patch(const std::string& path, std::function<void(Request&, Response&)> handler) {
-    routes_.push_back(std::make_unique<Route>("PATCH", path, handler));
+    addRoute("PATCH", path, handler);
 }
 
-bool Router::handleRequest(Request& req, Response& res) {
-    for (const auto& route : routes_) {
-        if (route->matches(req.method, req.path)) {
-            route->extractParams(req.path, req);
-            route->handler(req, res);
-            return true;
+bool Router::remove(const std::string& method, const std::string& path) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    const RouteTable* current = table_.load();
+    
+    auto next = std::make_unique<RouteTable>();
+    next->version = current->version + 1;
+    next->middleware = current->middleware;
+    next->routes.reserve(current->routes.size());
+    
+    bool removed = false;
+    for (const auto& route : current->routes) {
+        if (!removed && route->method == method && route->path == path) {
+            removed = true;
+            continue;
         }
+        next->routes.push_back(route);
+    }
+    
+    if (removed) {
+        publish(std::move(next));
+    }
+    return removed;
+}
+
+void Router::setMiddleware(const Middleware* middleware) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    const RouteTable* current = table_.load();
+    
+    auto next = std::make_unique<RouteTable>();
+    next->version = current->version + 1;
+    next->middleware = middleware;
+    next->routes.reserve(current->routes.size());
+    
+    for (const auto& route : current->routes) {
+        auto compiled = std::make_shared<Route>(*route);
+        compiled->middlewareChain = middleware ? middleware->compile(route->path)
+                                               : Middleware::Chain();
+        next->routes.push_back(std::move(compiled));
     }
-    return false;
+    
+    publish(std::move(next));
+}
+
+bool Router::handleRequest(Request& req, Response& res) {
+    static const std::function<void(Request&, Response&)> noRoute;
+    return runRoute(req, res, noRoute);
+}
+
+void Router::dispatch(Request& req, Response& res,
+                      const std::function<void(Request&, Response&)>& notFound) {
+    runRoute(req, res, notFound);
 }
 
 void Router::clear() {
-    routes_.clear();
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    const RouteTable* current = table_.load();
+    
+    auto next = std::make_unique<RouteTable>();
+    next->version = current->version + 1;
+    next->middleware = current->middleware;
+    publish(std::move(next));
 }
 
 size_t Router::getRouteCount() const {
-    return routes_.size();
+    ReadGuard guard(*this);
+    return guard.table().routes.size();
+}
+
+uint64_t Router::getVersion() const {
+    ReadGuard guard(*this);
+    return guard.table().version;
+}
+
+bool Router::runRoute(Request& req, Response& res,
+                      const std::function<void(Request&, Response&)>& notFound) {
+    const Middleware* middleware = nullptr;
+    std::shared_ptr<const Route> matched = findRoute(req, &middleware);
+    
+    // Handlers run outside the read section so they may themselves add or
+    // remove routes; the shared_ptr keeps the route alive until they return
+    if (!matched && !notFound) {
+        return false;
+    }
+    if (matched) {
+        matched->extractParams(req.path, req);
+    }
+    if (!middleware) {
+        if (matched) {
+            matched->handler(req, res);
+        } else {
+            notFound(req, res);
+        }
+        return matched != nullptr;
+    }
+    
+    // The chain was chosen for the path as received. Middleware may still
+    // rewrite the path or method (prefix stripping, trailing-slash
+    // normalization) through Request::rewrite, so the final handler is
+    // picked again if the rewrite count moved by the end of the chain.
+    struct Terminal {
+        const Router* router;
+        std::shared_ptr<const Route> route;
+        const std::function<void(Request&, Response&)>* notFound;
+        unsigned rewrites;
+        bool handled;
+    } terminal{this, matched, &notFound, req.rewriteCount(), matched != nullptr};
+    
+    Middleware::Handler finish = [state = &terminal](Request& req, Response& res) {
+        if (req.rewriteCount() != state->rewrites) {
+            const Middleware* unused = nullptr;
+            state->route = state->router->findRoute(req, &unused);
+            if (state->route) {
+                req.params.clear();
+                state->route->extractParams(req.path, req);
+            }
+        }
+        state->handled = state->route != nullptr;
+        if (state->route) {
+            state->route->handler(req, res);
+        } else if (*state->notFound) {
+            (*state->notFound)(req, res);
+        }
+    };
+    
+    if (matched) {
+        middleware->execute(matched->middlewareChain, req, res, finish);
+    } else {
+        middleware->execute(req, res, finish);
+    }
+    return terminal.handled;
+}
+
+std::shared_ptr<const Route> Router::findRoute(const Request& req, 
+                                               const Middleware** middleware) const {
+    ReadGuard guard(*this);
+    *middleware = guard.table().middleware;
+    for (const auto& route : guard.table().routes) {
+        if (route->matches(req.method, req.path)) {
+            return route;
+        }
+    }
+    return nullptr;
+}
+
+void Router::addRoute(const std::string& method, const std::string& path,
+                      std::function<void(Request&, Response&)> handler) {
+    // Compile the regex before taking the lock
+    auto route = std::make_shared<Route>(method, path, handler);
+    
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    const RouteTable* current = table_.load();
+    if (current->middleware) {
+        route->middlewareChain = current->middleware->compile(path);
+    }
+    
+    auto next = std::make_unique<RouteTable>();
+    next->version = current->version + 1;
+    next->middleware = current->middleware;
+    next->routes.reserve(current->routes.size() + 1);
+    next->routes = current->routes;
+    next->routes.push_back(std::move(route));
+    
+    publish(std::move(next));
+}
+
+void Router::publish(std::unique_ptr<RouteTable> next) {
+    // Caller holds writeMutex_
+    const RouteTable* old = table_.exchange(next.release());
+    synchronize();
+    delete old;
+}
+
+void Router::synchronize() {
+    // Flip the epoch so new readers register on the other counter, then wait
+    // for the old counter to drain. Doing it twice covers readers that loaded
+    // the epoch just before a flip.
+    for (int phase = 0; phase < 2; ++phase) {
+        unsigned old = epoch_.fetch_add(1) & 1;
+        while (readers_[old].value.load() != 0) {
+            std::this_thread::yield();
+        }
+    }
 }
 
 } // namespace httpapi 
\ No newline at end of file
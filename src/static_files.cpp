@@ -3,17 +3,822 @@
 #include <fstream>
 #include <sstream>
 #include <filesystem>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <algorithm>
+#include <random>
 
 namespace httpapi {
 
-StaticFileHandler::StaticFileHandler() {
+namespace {
+
+struct PrecompressedSibling {
+    const char* extension;
+    const char* encoding;
+};
+
+// In order of preference when the client weighs encodings equally
+const PrecompressedSibling kPrecompressedSiblings[] = {
+    {".br", "br"},
+    {".zst", "zstd"},
+    {".gz", "gzip"}
+};
+
+bool isPrecompressedSibling(const std::string& path) {
+    for (const auto& sibling : kPrecompressedSiblings) {
+        size_t length = std::strlen(sibling.extension);
+        if (path.size() > length && path.compare(path.size() - length, length, sibling.extension) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Cap on remembered file metadata, which unlike cached content has no byte
+// budget; request paths spelled differently get entries of their own
+const size_t kMaxDescribedFiles = 64 * 1024;
+
+ContentEncoding encodingOf(const std::string& name) {
+    if (name == "br") return ContentEncoding::Brotli;
+    if (name == "zstd") return ContentEncoding::Zstd;
+    if (name == "gzip") return ContentEncoding::Gzip;
+    return ContentEncoding::Identity;
+}
+
+} // namespace
+
+StaticFileHandler::StaticFileHandler()
+    : cacheBytes_(0), maxCacheBytes_(32 * 1024 * 1024), maxCachedFileSize_(256 * 1024),
+      generation_(0), useClock_(0) {
 }
 
 StaticFileHandler::~StaticFileHandler() {
+    stop();
+}
+
+void StaticFileHandler::setStaticPath(const std::string& urlPath, const std::string& filePath,
+                                      const StaticFileOptions& options) {
+    Mount mount;
+    mount.directory = filePath;
+    mount.options = options;
+    try {
+        mount.root = std::filesystem::canonical(filePath).string();
+    } catch (...) {
+        // Missing directory: the mount never matches
+    }
+    staticPaths_[urlPath] = mount;
+}
+
+void StaticFileHandler::setCacheLimits(size_t maxBytes, size_t maxFileSize) {
+    maxCacheBytes_ = maxBytes;
+    maxCachedFileSize_ = maxFileSize;
+}
+
+void StaticFileHandler::start() {
+    for (auto& staticPath : staticPaths_) {
+        Mount& mount = staticPath.second;
+        if (mount.root.empty()) {
+            continue;
+        }
+        bool indexed = mount.options.preindex || mount.options.fingerprint;
+        bool watched = false;
+        
+        bool wantsWatch = indexed || mount.options.precompressed ||
+                          (mount.options.memoryCache && maxCacheBytes_ > 0);
+        if (wantsWatch) {
+            auto watcher = std::make_unique<FileWatcher>();
+            watched = watcher->start(mount.root, [this](const std::string& path) {
+                invalidate(path);
+            });
+            if (watched) {
+                watchers_.push_back(std::move(watcher));
+            }
+        }
+        
+        // serve() may still be running on a client thread from a previous
+        // start; it reads these flags under the same lock
+        {
+            std::unique_lock<std::shared_mutex> lock(cacheMutex_);
+            mount.indexed = indexed;
+            mount.watched = watched;
+        }
+        
+        // Index after the watcher is up so no change slips between the two
+        if (indexed) {
+            indexMount(staticPath.first, mount, mount.root);
+        }
+    }
+}
+
+void StaticFileHandler::stop() {
+    // Joins the watcher threads, so no invalidation runs past this point
+    watchers_.clear();
+    
+    // Detached client threads may still be inside serve(), which reads the
+    // mount flags under this lock
+    std::unique_lock<std::shared_mutex> lock(cacheMutex_);
+    for (auto& staticPath : staticPaths_) {
+        staticPath.second.watched = false;
+        staticPath.second.indexed = false;
+    }
+    cache_.clear();
+    index_.clear();
+    described_.clear();
+    assets_.clear();
+    cacheBytes_ = 0;
+}
+
+std::string StaticFileHandler::assetUrl(const std::string& urlPath) const {
+    std::shared_lock<std::shared_mutex> lock(cacheMutex_);
+    auto it = assets_.find(urlPath);
+    return it != assets_.end() ? it->second : urlPath;
+}
+
+bool StaticFileHandler::serve(const Request& req, Response& res) {
+    // Mounts are fixed once serving starts; only their flags change, and
+    // those are read under the cache lock
+    const Mount* mount = findMount(req.path);
+    if (!mount) {
+        return false;
+    }
+    
+    // Hot path: a cached file is answered without touching the filesystem,
+    // an indexed or already described one without resolving or stat-ing
+    // its path
+    std::shared_ptr<const StaticFile> file;
+    bool indexed;
+    bool watched;
+    {
+        std::shared_lock<std::shared_mutex> lock(cacheMutex_);
+        indexed = mount->indexed;
+        watched = mount->watched;
+        auto cached = cache_.find(req.path);
+        if (cached != cache_.end()) {
+            file = cached->second;
+        } else {
+            auto it = index_.find(req.path);
+            if (it != index_.end()) {
+                file = it->second;
+            } else {
+                auto described = described_.find(req.path);
+                if (described != described_.end()) {
+                    file = described->second;
+                }
+            }
+        }
+    }
+    
+    uint64_t generation = generation_.load();
+    
+    if (!file) {
+        // Everything under an indexed mount is known; no filesystem lookup
+        if (indexed) {
+            return false;
+        }
+        
+        std::string resolvedPath = resolvePath(req.path);
+        if (resolvedPath.empty() || !isPathSafe(resolvedPath, *mount)) {
+            return false;
+        }
+        
+        FileInfo info;
+        if (!statFile(resolvedPath, info)) {
+            return false;
+        }
+        // Siblings are only probed where the watcher keeps the result
+        // current; the description is then kept apart from the content, so
+        // large, ranged and uncacheable files skip this work as well
+        std::shared_ptr<StaticFile> described = describeFile(resolvedPath, info, *mount, watched);
+        if (watched) {
+            insertDescribed(req.path, described, generation);
+        }
+        file = std::move(described);
+    }
+    
+    // Pick the representation: the file itself or a precompressed sibling
+    std::shared_ptr<const StaticFile> chosen = file;
+    std::string cacheKey = req.path;
+    if (!file->variants.empty()) {
+        res.set("Vary", "Accept-Encoding");
+        
+        std::vector<ContentEncoding> offered;
+        for (const auto& variant : file->variants) {
+            offered.push_back(variant->info.size < file->info.size ? 
+                              encodingOf(variant->contentEncoding) : ContentEncoding::Identity);
+        }
+        ContentEncoding encoding = Compression::negotiate(req.get("Accept-Encoding"), offered);
+        for (const auto& variant : file->variants) {
+            if (encoding != ContentEncoding::Identity && 
+                variant->contentEncoding == Compression::encodingName(encoding)) {
+                cacheKey += '\n' + variant->contentEncoding;
+                std::shared_lock<std::shared_mutex> lock(cacheMutex_);
+                auto cached = cache_.find(cacheKey);
+                chosen = cached != cache_.end() ? cached->second : variant;
+                break;
+            }
+        }
+    }
+    
+    // Validators are checked against metadata only; the file is not opened
+    bool notModified = isNotModified(req, *chosen);
+    
+    std::vector<ByteRange> ranges;
+    bool partial = !notModified && wantsRange(req, *chosen, ranges);
+    if (partial && ranges.empty()) {
+        setFileHeaders(res, *chosen);
+        res.status(416);
+        res.set("Content-Range", "bytes */" + std::to_string(chosen->info.size));
+        res.send("");
+        return true;
+    }
+    
+    if (notModified || chosen->content) {
+        chosen->lastUsed = ++useClock_;
+        if (partial) {
+            return respondPartial(res, *chosen, ranges, chosen->content.get(), nullptr);
+        }
+        respond(res, *chosen, notModified);
+        return true;
+    }
+    
+    // Large files are sent from a shared mapping instead of a private copy
+    uint64_t mmapThreshold = mount->options.mmapThreshold;
+    if (mmapThreshold > 0 && chosen->info.size >= mmapThreshold) {
+        std::shared_ptr<const FileRegion> region = mapFile(*chosen);
+        if (region) {
+            if (partial) {
+                return respondPartial(res, *chosen, ranges, nullptr, std::move(region));
+            }
+            respond(res, *chosen, false, std::move(region));
+            return true;
+        }
+    }
+    
+    // Only the requested bytes are read for a range of an uncached file
+    if (partial) {
+        return respondPartial(res, *chosen, ranges, nullptr, nullptr);
+    }
+    
+    std::string content;
+    if (!readFile(chosen->filePath, content)) {
+        return false;
+    }
+    std::shared_ptr<StaticFile> loaded = chosen->describe();
+    loaded->content = std::make_shared<const std::string>(std::move(content));
+    
+    respond(res, *loaded, false);
+    
+    if (watched && mount->options.memoryCache && 
+        loaded->content->size() <= maxCachedFileSize_) {
+        insertCached(cacheKey, loaded, generation);
+    }
+    return true;
+}
+
+std::shared_ptr<StaticFileHandler::StaticFile> StaticFileHandler::StaticFile::describe() const {
+    auto copy = std::make_shared<StaticFile>();
+    copy->filePath = filePath;
+    copy->info = info;
+    copy->contentType = contentType;
+    copy->etag = etag;
+    copy->lastModified = lastModified;
+    copy->cacheControl = cacheControl;
+    copy->contentEncoding = contentEncoding;
+    copy->variants = variants;
+    return copy;
+}
+
+std::shared_ptr<StaticFileHandler::StaticFile> StaticFileHandler::describeFile(
+        const std::string& path, const FileInfo& info, const Mount& mount, bool probeSiblings) {
+    const StaticFileOptions& options = mount.options;
+    
+    auto file = std::make_shared<StaticFile>();
+    file->filePath = path;
+    file->info = info;
+    file->contentType = getMimeType(getFileExtension(path));
+    file->etag = options.etag ? makeETag(info) : "";
+    file->lastModified = options.lastModified ? Utils::formatHttpDate(info.modified) : "";
+    file->cacheControl = options.cacheControl;
+    
+    if (!probeSiblings || !options.precompressed || isPrecompressedSibling(path)) {
+        return file;
+    }
+    
+    for (const auto& sibling : kPrecompressedSiblings) {
+        std::string siblingPath = path + sibling.extension;
+        FileInfo siblingInfo;
+        if (!statFile(siblingPath, siblingInfo)) {
+            continue;
+        }
+        try {
+            if (!isPathSafe(std::filesystem::canonical(siblingPath).string(), mount)) {
+                continue;
+            }
+        } catch (...) {
+            continue;
+        }
+        
+        // Same resource, different bytes: give the variant its own validator
+        auto variant = std::make_shared<StaticFile>();
+        variant->filePath = siblingPath;
+        variant->info = siblingInfo;
+        variant->contentType = file->contentType;
+        variant->etag = options.etag ? makeETag(siblingInfo) : "";
+        if (!variant->etag.empty()) {
+            variant->etag.insert(variant->etag.size() - 1, std::string("-") + sibling.encoding);
+        }
+        variant->lastModified = file->lastModified;
+        variant->cacheControl = file->cacheControl;
+        variant->contentEncoding = sibling.encoding;
+        file->variants.push_back(variant);
+    }
+    return file;
+}
+
+void StaticFileHandler::indexMount(const std::string& urlPath, const Mount& mount,
+                                   const std::string& changedPath) {
+    namespace fs = std::filesystem;
+    
+    std::string urlPrefix = urlPath;
+    if (!urlPrefix.empty() && urlPrefix.back() == '/') {
+        urlPrefix.pop_back();
+    }
+    
+    // Walk outside the lock. Symlinks are followed but must stay inside the
+    // mount: traversal is ruled out here rather than on every request.
+    std::vector<std::pair<std::string, std::shared_ptr<const StaticFile>>> found;
+    std::vector<std::pair<std::string, std::string>> assets;
+    auto add = [&](const fs::path& path) {
+        try {
+            std::string canonicalPath = fs::canonical(path).string();
+            FileInfo info;
+            if (!isPathSafe(canonicalPath, mount) || !statFile(canonicalPath, info)) {
+                return;
+            }
+            std::string relative = path.lexically_relative(mount.root).generic_string();
+            std::string url = urlPrefix + "/" + relative;
+            std::shared_ptr<StaticFile> file = describeFile(path.string(), info, mount, true);
+            
+            // Content-addressed alias; precompressed siblings ride along as
+            // variants of their file rather than getting names of their own
+            std::string hash;
+            if (mount.options.fingerprint && 
+                !(mount.options.precompressed && isPrecompressedSibling(url)) &&
+                hashFile(path.string(), hash)) {
+                std::string alias = fingerprintUrl(url, hash);
+                found.emplace_back(alias, makeImmutable(*file));
+                assets.emplace_back(url, alias);
+            }
+            found.emplace_back(url, std::move(file));
+        } catch (...) {
+            // Vanished or unreadable; a later event will bring it back
+        }
+    };
+    
+    std::error_code error;
+    if (fs::is_directory(changedPath, error)) {
+        auto options = fs::directory_options::follow_directory_symlink |
+                       fs::directory_options::skip_permission_denied;
+        for (fs::recursive_directory_iterator it(changedPath, options, error), end; 
+             !error && it != end; it.increment(error)) {
+            if (it->is_regular_file(error)) {
+                add(it->path());
+            }
+        }
+    } else if (fs::is_regular_file(changedPath, error)) {
+        add(changedPath);
+    }
+    
+    // Replace whatever the index held at or below changedPath
+    std::string prefix = changedPath;
+    if (!prefix.empty() && prefix.back() != '/' && prefix.back() != '\\') {
+        prefix += fs::path::preferred_separator;
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(cacheMutex_);
+    for (auto it = index_.begin(); it != index_.end(); ) {
+        const std::string& path = it->second->filePath;
+        bool underMount = it->first.compare(0, urlPrefix.size() + 1, urlPrefix + "/") == 0;
+        if (underMount && (path == changedPath || path.compare(0, prefix.size(), prefix) == 0)) {
+            assets_.erase(it->first);
+            it = index_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto& entry : found) {
+        index_[entry.first] = std::move(entry.second);
+    }
+    for (auto& entry : assets) {
+        assets_[entry.first] = std::move(entry.second);
+    }
+}
+
+bool StaticFileHandler::hashFile(const std::string& path, std::string& hash) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    // FNV-1a: only needs to change when the content does
+    uint64_t value = 14695981039346656037ULL;
+    char buffer[64 * 1024];
+    while (file) {
+        file.read(buffer, sizeof(buffer));
+        for (std::streamsize i = 0; i < file.gcount(); ++i) {
+            value ^= static_cast<unsigned char>(buffer[i]);
+            value *= 1099511628211ULL;
+        }
+    }
+    if (file.bad()) {
+        return false;
+    }
+    
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(value));
+    hash.assign(hex, 12);
+    return true;
+}
+
+std::string StaticFileHandler::fingerprintUrl(const std::string& urlPath, const std::string& hash) {
+    // Before the extension of the last segment: app.min.js -> app.min.<hash>.js
+    size_t slash = urlPath.rfind('/');
+    size_t dot = urlPath.rfind('.');
+    size_t nameStart = slash == std::string::npos ? 0 : slash + 1;
+    if (dot == std::string::npos || dot <= nameStart) {
+        return urlPath + "." + hash;
+    }
+    return urlPath.substr(0, dot) + "." + hash + urlPath.substr(dot);
+}
+
+std::shared_ptr<StaticFileHandler::StaticFile> StaticFileHandler::makeImmutable(const StaticFile& file) {
+    // The URL changes whenever the content does, so clients never need to ask again
+    static const std::string immutable = "public, max-age=31536000, immutable";
+    
+    std::shared_ptr<StaticFile> copy = file.describe();
+    copy->cacheControl = immutable;
+    for (auto& variant : copy->variants) {
+        std::shared_ptr<StaticFile> immutableVariant = variant->describe();
+        immutableVariant->cacheControl = immutable;
+        variant = std::move(immutableVariant);
+    }
+    return copy;
+}
+
+void StaticFileHandler::respond(Response& res, const StaticFile& file, bool notModified,
+                                std::shared_ptr<const FileRegion> region) {
+    setFileHeaders(res, file);
+    
+    if (notModified) {
+        res.status(304);
+        res.body.clear();
+        return;
+    }
+    
+    res.status(200);
+    res.set("Content-Type", file.contentType);
+    if (region) {
+        res.send(std::move(region));
+    } else {
+        res.send(*file.content);
+    }
+}
+
+void StaticFileHandler::setFileHeaders(Response& res, const StaticFile& file) {
+    res.set("Accept-Ranges", "bytes");
+    if (!file.contentEncoding.empty()) {
+        res.set("Content-Encoding", file.contentEncoding);
+    }
+    if (!file.etag.empty()) {
+        res.set("ETag", file.etag);
+    }
+    if (!file.lastModified.empty()) {
+        res.set("Last-Modified", file.lastModified);
+    }
+    if (!file.cacheControl.empty()) {
+        res.set("Cache-Control", file.cacheControl);
+    }
+}
+
+bool StaticFileHandler::wantsRange(const Request& req, const StaticFile& file, std::vector<ByteRange>& ranges) {
+    // Range is only defined for GET (RFC 9110 14.2)
+    std::string range = req.get("Range");
+    if (range.empty() || req.method != "GET") {
+        return false;
+    }
+    
+    // If-Range: send the ranges only if the client's copy is still current,
+    // otherwise the whole file. Requires a strong match.
+    std::string ifRange = Utils::trim(req.get("If-Range"));
+    if (!ifRange.empty()) {
+        if (ifRange.front() == '"' || ifRange.compare(0, 2, "W/") == 0) {
+            if (file.etag.empty() || ifRange != file.etag) {
+                return false;
+            }
+        } else {
+            std::time_t date;
+            if (file.lastModified.empty() || !Utils::parseHttpDate(ifRange, date) || 
+                date != file.info.modified) {
+                return false;
+            }
+        }
+    }
+    
+    return parseRange(range, file.info.size, ranges);
+}
+
+bool StaticFileHandler::parseRange(const std::string& header, uint64_t size, std::vector<ByteRange>& ranges) {
+    // More ranges than this is not a media player seeking; serve the whole file
+    const size_t maxRanges = 64;
+    
+    std::string value = Utils::trim(header);
+    if (Utils::toLowerCase(value.substr(0, 6)) != "bytes=") {
+        return false;
+    }
+    
+    auto parseNumber = [](const std::string& text, uint64_t& number) {
+        if (text.empty() || text.size() > 19) {
+            return false;
+        }
+        number = 0;
+        for (char c : text) {
+            if (c < '0' || c > '9') {
+                return false;
+            }
+            number = number * 10 + static_cast<uint64_t>(c - '0');
+        }
+        return true;
+    };
+    
+    std::vector<std::string> specs = Utils::split(value.substr(6), ',');
+    if (specs.size() > maxRanges) {
+        return false;
+    }
+    
+    // Any malformed spec invalidates the whole header, which is then ignored;
+    // well-formed specs beyond the end of the file are dropped
+    size_t wellFormed = 0;
+    for (const auto& item : specs) {
+        std::string spec = Utils::trim(item);
+        if (spec.empty()) {
+            continue;
+        }
+        size_t dash = spec.find('-');
+        if (dash == std::string::npos) {
+            return false;
+        }
+        ++wellFormed;
+        
+        uint64_t first;
+        uint64_t last;
+        if (dash == 0) {
+            // Suffix range: the final N bytes
+            uint64_t length;
+            if (!parseNumber(spec.substr(1), length)) {
+                return false;
+            }
+            if (length == 0 || size == 0) {
+                continue;
+            }
+            first = length >= size ? 0 : size - length;
+            last = size - 1;
+        } else {
+            if (!parseNumber(spec.substr(0, dash), first)) {
+                return false;
+            }
+            if (dash + 1 == spec.size()) {
+                last = UINT64_MAX;
+            } else if (!parseNumber(spec.substr(dash + 1), last) || last < first) {
+                return false;
+            }
+            if (first >= size) {
+                continue;
+            }
+            last = std::min(last, size - 1);
+        }
+        ranges.push_back(ByteRange{first, last});
+    }
+    
+    // Nothing but empty list elements ("bytes=,") is not a byte range set at
+    // all (RFC 9110 14.1.1), so the header is ignored rather than unsatisfiable
+    if (wellFormed == 0) {
+        return false;
+    }
+    
+    // Merge overlapping and adjacent ranges so a response can never be
+    // larger than the file plus part headers
+    std::sort(ranges.begin(), ranges.end(), [](const ByteRange& a, const ByteRange& b) {
+        return a.first < b.first;
+    });
+    std::vector<ByteRange> merged;
+    for (const auto& range : ranges) {
+        if (!merged.empty() && range.first <= merged.back().last + 1) {
+            merged.back().last = std::max(merged.back().last, range.last);
+        } else {
+            merged.push_back(range);
+        }
+    }
+    ranges.swap(merged);
+    return true;
+}
+
+bool StaticFileHandler::respondPartial(Response& res, const StaticFile& file, const std::vector<ByteRange>& ranges,
+                                       const std::string* content, std::shared_ptr<const FileRegion> region) {
+    // Copy one range out of whichever source holds the file
+    auto append = [&](const ByteRange& range, std::string& out) {
+        size_t offset = static_cast<size_t>(range.first);
+        size_t length = static_cast<size_t>(range.last - range.first + 1);
+        if (region) {
+            out.append(region->view().substr(offset, length));
+            return true;
+        }
+        if (content) {
+            out.append(*content, offset, length);
+            return true;
+        }
+        return readRange(file.filePath, range, out);
+    };
+    
+    std::string total = "/" + std::to_string(file.info.size);
+    auto contentRange = [&](const ByteRange& range) {
+        return "bytes " + std::to_string(range.first) + "-" + std::to_string(range.last) + total;
+    };
+    
+    setFileHeaders(res, file);
+    res.status(206);
+    
+    if (ranges.size() == 1) {
+        const ByteRange& range = ranges.front();
+        res.set("Content-Type", file.contentType);
+        res.set("Content-Range", contentRange(range));
+        if (region) {
+            res.send(std::move(region), static_cast<size_t>(range.first),
+                     static_cast<size_t>(range.last - range.first + 1));
+            return true;
+        }
+        std::string body;
+        if (!append(range, body)) {
+            return false;
+        }
+        res.send(body);
+        return true;
+    }
+    
+    // multipart/byteranges (RFC 9110 14.6)
+    static thread_local std::mt19937_64 random(std::random_device{}());
+    char boundary[24];
+    std::snprintf(boundary, sizeof(boundary), "%016llx", static_cast<unsigned long long>(random()));
+    
+    std::string body;
+    for (const auto& range : ranges) {
+        body += "--";
+        body += boundary;
+        body += "\r\nContent-Type: " + file.contentType;
+        body += "\r\nContent-Range: " + contentRange(range) + "\r\n\r\n";
+        if (!append(range, body)) {
+            return false;
+        }
+        body += "\r\n";
+    }
+    body += "--";
+    body += boundary;
+    body += "--\r\n";
+    
+    res.set("Content-Type", std::string("multipart/byteranges; boundary=") + boundary);
+    res.send(body);
+    return true;
 }
 
-void StaticFileHandler::setStaticPath(const std::string& urlPath, const std::string& filePath) {
-    staticPaths_[urlPath] = filePath;
+bool StaticFileHandler::readRange(const std::string& path, const ByteRange& range, std::string& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    size_t length = static_cast<size_t>(range.last - range.first + 1);
+    size_t offset = out.size();
+    out.resize(offset + length);
+    file.seekg(static_cast<std::streamoff>(range.first));
+    file.read(&out[offset], static_cast<std::streamsize>(length));
+    return static_cast<size_t>(file.gcount()) == length;
+}
+
+std::shared_ptr<const FileRegion> StaticFileHandler::mapFile(const StaticFile& file) {
+    std::lock_guard<std::mutex> lock(regionMutex_);
+    
+    auto it = regions_.find(file.filePath);
+    if (it != regions_.end() && it->second.info == file.info) {
+        if (auto region = it->second.region.lock()) {
+            return region;
+        }
+    }
+    
+    std::shared_ptr<const FileRegion> region = FileRegion::map(file.filePath);
+    if (!region || region->size() != file.info.size) {
+        // Changed between stat and map; let the caller read it instead
+        return nullptr;
+    }
+    
+    // Drop entries whose last response has finished
+    for (auto entry = regions_.begin(); entry != regions_.end(); ) {
+        if (entry->second.region.expired()) {
+            entry = regions_.erase(entry);
+        } else {
+            ++entry;
+        }
+    }
+    regions_[file.filePath] = MappedFile{file.info, region};
+    return region;
+}
+
+void StaticFileHandler::insertCached(const std::string& key, std::shared_ptr<const StaticFile> file,
+                                     uint64_t generation) {
+    std::unique_lock<std::shared_mutex> lock(cacheMutex_);
+    
+    // A change notification arrived while the file was being read
+    if (generation_.load() != generation || cache_.count(key)) {
+        return;
+    }
+    
+    file->lastUsed = ++useClock_;
+    cacheBytes_ += file->content->size();
+    cache_[key] = std::move(file);
+    
+    // Evict least recently used files; hits only take the shared lock, so
+    // recency is an atomic stamp rather than list order
+    while (cacheBytes_ > maxCacheBytes_ && !cache_.empty()) {
+        auto oldest = cache_.begin();
+        for (auto it = cache_.begin(); it != cache_.end(); ++it) {
+            if (it->second->lastUsed < oldest->second->lastUsed) {
+                oldest = it;
+            }
+        }
+        cacheBytes_ -= oldest->second->content->size();
+        cache_.erase(oldest);
+    }
+}
+
+void StaticFileHandler::insertDescribed(const std::string& key, std::shared_ptr<const StaticFile> file,
+                                        uint64_t generation) {
+    std::unique_lock<std::shared_mutex> lock(cacheMutex_);
+    if (generation_.load() != generation || described_.size() >= kMaxDescribedFiles) {
+        return;
+    }
+    described_.emplace(key, std::move(file));
+}
+
+void StaticFileHandler::invalidate(const std::string& changedPath) {
+    invalidatePath(changedPath);
+    
+    // The file a precompressed sibling belongs to gains or loses a variant
+    if (isPrecompressedSibling(changedPath)) {
+        invalidatePath(changedPath.substr(0, changedPath.find_last_of('.')));
+    }
+}
+
+void StaticFileHandler::invalidatePath(const std::string& changedPath) {
+    generation_.fetch_add(1);
+    
+    // changedPath may be a directory (renamed, deleted, or a watcher overflow)
+    std::string prefix = changedPath;
+    if (!prefix.empty() && prefix.back() != '/' && prefix.back() != '\\') {
+        prefix += std::filesystem::path::preferred_separator;
+    }
+    
+    {
+        std::unique_lock<std::shared_mutex> lock(cacheMutex_);
+        for (auto it = cache_.begin(); it != cache_.end(); ) {
+            const std::string& path = it->second->filePath;
+            if (path == changedPath || path.compare(0, prefix.size(), prefix) == 0) {
+                cacheBytes_ -= it->second->content->size();
+                it = cache_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (auto it = described_.begin(); it != described_.end(); ) {
+            const std::string& path = it->second->filePath;
+            if (path == changedPath || path.compare(0, prefix.size(), prefix) == 0) {
+                it = described_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    
+    for (const auto& staticPath : staticPaths_) {
+        const Mount& mount = staticPath.second;
+        if (mount.indexed && (changedPath == mount.root || 
+                              changedPath.compare(0, mount.root.size() + 1, 
+                                                  mount.root + prefix.back()) == 0)) {
+            indexMount(staticPath.first, mount, changedPath);
+        }
+    }
+    
+    // A request that read the old index entry must not cache what it read
+    generation_.fetch_add(1);
 }
 
 bool StaticFileHandler::serveFile(const std::string& requestPath, std::string& content, 
@@ -84,6 +889,69 @@ bool StaticFileHandler::fileExists(const std::string& path) {
     }
 }
 
+bool StaticFileHandler::statFile(const std::string& path, FileInfo& info) {
+    try {
+        std::filesystem::directory_entry entry(path);
+        if (!entry.is_regular_file()) {
+            return false;
+        }
+        info.size = entry.file_size();
+        
+        // file_time_type has no portable epoch in C++17; rebase it onto system_clock
+        auto fileTime = entry.last_write_time();
+        auto systemTime = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+            fileTime - std::filesystem::file_time_type::clock::now() + std::chrono::system_clock::now());
+        info.modified = std::chrono::system_clock::to_time_t(systemTime);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+std::string StaticFileHandler::makeETag(const FileInfo& info) {
+    char buffer[48];
+    std::snprintf(buffer, sizeof(buffer), "\"%llx-%llx\"",
+                  static_cast<unsigned long long>(info.modified),
+                  static_cast<unsigned long long>(info.size));
+    return buffer;
+}
+
+bool StaticFileHandler::isNotModified(const Request& req, const StaticFile& file) {
+    if (req.method != "GET" && req.method != "HEAD") {
+        return false;
+    }
+    
+    // If-None-Match takes precedence over If-Modified-Since (RFC 9110 13.2.2)
+    std::string ifNoneMatch = req.get("If-None-Match");
+    if (!ifNoneMatch.empty()) {
+        if (file.etag.empty()) {
+            return false;
+        }
+        for (const auto& item : Utils::split(ifNoneMatch, ',')) {
+            std::string candidate = Utils::trim(item);
+            if (candidate == "*") {
+                return true;
+            }
+            // Weak comparison
+            if (candidate.compare(0, 2, "W/") == 0) {
+                candidate = candidate.substr(2);
+            }
+            if (candidate == file.etag) {
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    std::string ifModifiedSince = req.get("If-Modified-Since");
+    std::time_t since;
+    if (!file.lastModified.empty() && !ifModifiedSince.empty() && 
+        Utils::parseHttpDate(ifModifiedSince, since)) {
+        return file.info.modified <= since;
+    }
+    return false;
+}
+
 bool StaticFileHandler::readFile(const std::string& path, std::string& content) {
     try {
         std::ifstream file(path, std::ios::binary);
@@ -100,16 +968,31 @@ bool StaticFileHandler::readFile(const std::string& path, std::string& content)
     }
 }
 
-std::string StaticFileHandler::resolvePath(const std::string& requestPath) {
+const StaticFileHandler::Mount* StaticFileHandler::findMount(const std::string& requestPath) const {
+    for (const auto& staticPath : staticPaths_) {
+        if (requestPath.compare(0, staticPath.first.size(), staticPath.first) == 0) {
+            return &staticPath.second;
+        }
+    }
+    return nullptr;
+}
+
+std::string StaticFileHandler::resolvePath(const std::string& requestPath, const Mount** mount) {
     // Find the matching static path
     for (const auto& staticPath : staticPaths_) {
         if (requestPath.find(staticPath.first) == 0) {
+            if (mount) {
+                *mount = &staticPath.second;
+            }
             std::string relativePath = requestPath.substr(staticPath.first.length());
             if (relativePath.empty() || relativePath[0] != '/') {
                 relativePath = "/" + relativePath;
             }
             
-            std::string fullPath = staticPath.second + relativePath;
+            if (staticPath.second.root.empty()) {
+                return "";
+            }
+            std::string fullPath = staticPath.second.root + relativePath;
             
             // Normalize path
             try {
@@ -125,34 +1008,29 @@ std::string StaticFileHandler::resolvePath(const std::string& requestPath) {
 }
 
 bool StaticFileHandler::isPathSafe(const std::string& path) {
-    // Check for path traversal attacks
-    if (Utils::containsPathTraversal(path)) {
+    for (const auto& staticPath : staticPaths_) {
+        if (isPathSafe(path, staticPath.second)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool StaticFileHandler::isPathSafe(const std::string& path, const Mount& mount) {
+    if (mount.root.empty()) {
         return false;
     }
     
-    // Check if path is within the allowed directory
-    try {
-        std::filesystem::path filePath(path);
-        std::filesystem::path canonicalPath = std::filesystem::canonical(filePath);
-        
-        // For each static path, check if the canonical path is within the static directory
-        for (const auto& staticPath : staticPaths_) {
-            std::filesystem::path staticDir(staticPath.second);
-            std::filesystem::path canonicalStaticDir = std::filesystem::canonical(staticDir);
-            
-            // Check if the file path starts with the static directory path
-            std::string filePathStr = canonicalPath.string();
-            std::string staticDirStr = canonicalStaticDir.string();
-            
-            if (filePathStr.find(staticDirStr) == 0) {
-                return true;
-            }
-        }
-        
-        return false;
-    } catch (...) {
+    // path is already canonical ("..", symlinks and separators resolved), so
+    // traversal shows up as a path outside the mount's canonical root
+    if (path.compare(0, mount.root.size(), mount.root) != 0) {
         return false;
     }
+    if (path.size() == mount.root.size()) {
+        return true;
+    }
+    char next = path[mount.root.size()];
+    return next == '/' || next == '\\' || mount.root.back() == '/' || mount.root.back() == '\\';
 }
 
 } // namespace httpapi 
\ No newline at end of file
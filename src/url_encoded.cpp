@@ -0,0 +1,125 @@
+#include "httpapi/url_encoded.hpp"
+#include <algorithm>
+
+namespace httpapi {
+
+namespace {
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool needsDecoding(std::string_view text) {
+    return text.find_first_of("%+") != std::string_view::npos;
+}
+
+} // namespace
+
+void UrlEncodedIndex::decode(std::string_view text, std::string& out) {
+    out.reserve(out.size() + text.size());
+    size_t run = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '+') {
+            out.append(text.data() + run, i - run);
+            out += ' ';
+            run = i + 1;
+        } else if (c == '%' && i + 2 < text.size()) {
+            int high = hexValue(text[i + 1]);
+            int low = hexValue(text[i + 2]);
+            if (high >= 0 && low >= 0) {
+                out.append(text.data() + run, i - run);
+                out += static_cast<char>(high * 16 + low);
+                i += 2;
+                run = i + 1;
+            }
+        }
+    }
+    out.append(text.data() + run, text.size() - run);
+}
+
+void UrlEncodedIndex::index(std::string_view text) {
+    fields_.clear();
+    size_ = text.size();
+    indexed_ = true;
+    fields_.reserve(static_cast<size_t>(std::count(text.begin(), text.end(), '&')) + 1);
+    
+    size_t pos = 0;
+    while (pos <= text.size()) {
+        size_t end = text.find('&', pos);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        if (end > pos) {
+            std::string_view pair = text.substr(pos, end - pos);
+            size_t equals = pair.find('=');
+            size_t keyLength = equals == std::string_view::npos ? pair.size() : equals;
+            size_t valueOffset = equals == std::string_view::npos ? end : pos + equals + 1;
+            
+            Field field;
+            field.keyOffset = pos;
+            field.keyLength = keyLength;
+            field.valueOffset = valueOffset;
+            field.valueLength = end - valueOffset;
+            field.keyEscaped = needsDecoding(pair.substr(0, keyLength));
+            field.valueEscaped = needsDecoding(text.substr(valueOffset, field.valueLength));
+            field.valueDecoded = false;
+            if (field.keyEscaped) {
+                decode(pair.substr(0, keyLength), field.key);
+            }
+            fields_.push_back(std::move(field));
+        }
+        pos = end + 1;
+    }
+}
+
+std::string_view UrlEncodedIndex::keyOf(std::string_view text, const Field& field) const {
+    return field.keyEscaped ? std::string_view(field.key) : text.substr(field.keyOffset, field.keyLength);
+}
+
+std::string_view UrlEncodedIndex::valueOf(std::string_view text, Field& field) {
+    if (!field.valueEscaped) {
+        return text.substr(field.valueOffset, field.valueLength);
+    }
+    if (!field.valueDecoded) {
+        decode(text.substr(field.valueOffset, field.valueLength), field.value);
+        field.valueDecoded = true;
+    }
+    return field.value;
+}
+
+std::optional<std::string_view> UrlEncodedIndex::find(std::string_view text, std::string_view name) {
+    if (!indexed_ || text.size() != size_) {
+        index(text);
+    }
+    for (Field& field : fields_) {
+        if (keyOf(text, field) == name) {
+            return valueOf(text, field);
+        }
+    }
+    return std::nullopt;
+}
+
+std::vector<std::string_view> UrlEncodedIndex::findAll(std::string_view text, std::string_view name) {
+    if (!indexed_ || text.size() != size_) {
+        index(text);
+    }
+    std::vector<std::string_view> values;
+    for (Field& field : fields_) {
+        if (keyOf(text, field) == name) {
+            values.push_back(valueOf(text, field));
+        }
+    }
+    return values;
+}
+
+void UrlEncodedIndex::clear() {
+    fields_.clear();
+    size_ = 0;
+    indexed_ = false;
+}
+
+} // namespace httpapi 
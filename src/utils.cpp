@@ -1,4 +1,5 @@
 #include "httpapi/utils.hpp"
+#include "httpapi/url_encoded.hpp"
 #include <algorithm>
 #include <cctype>
 #include <sstream>
@@ -6,6 +7,7 @@
 #include <filesystem>
 #include <chrono>
 #include <ctime>
+#include <cstdio>
 
 namespace httpapi {
 
@@ -58,19 +60,7 @@ std::string Utils::join(const std::vector<std::string>& parts, const std::string
 
 std::string Utils::urlDecode(const std::string& str) {
     std::string result;
-    for (size_t i = 0; i < str.length(); ++i) {
-        if (str[i] == '%' && i + 2 < str.length()) {
-            int value;
-            std::istringstream iss(str.substr(i + 1, 2));
-            iss >> std::hex >> value;
-            result += static_cast<char>(value);
-            i += 2;
-        } else if (str[i] == '+') {
-            result += ' ';
-        } else {
-            result += str[i];
-        }
-    }
+    UrlEncodedIndex::decode(str, result);
     return result;
 }
 
@@ -134,8 +124,8 @@ std::string Utils::normalizeHeaderName(const std::string& name) {
     return result;
 }
 
-std::unordered_map<std::string, std::string> Utils::parseHeaders(const std::string& headerText) {
-    std::unordered_map<std::string, std::string> headers;
+Headers Utils::parseHeaders(const std::string& headerText) {
+    Headers headers;
     std::vector<std::string> lines = split(headerText, '\n');
     
     for (const auto& line : lines) {
@@ -144,9 +134,7 @@ std::unordered_map<std::string, std::string> Utils::parseHeaders(const std::stri
         
         size_t colonPos = trimmed.find(':');
         if (colonPos != std::string::npos) {
-            std::string name = normalizeHeaderName(trimmed.substr(0, colonPos));
-            std::string value = trim(trimmed.substr(colonPos + 1));
-            headers[name] = value;
+            headers.add(std::string_view(trimmed).substr(0, colonPos), trim(trimmed.substr(colonPos + 1)));
         }
     }
     
@@ -169,6 +157,82 @@ std::string Utils::formatTime(const std::string& format) {
     return ss.str();
 }
 
+namespace {
+
+const char* const kWeekdays[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+const char* const kMonths[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                               "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+// Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's algorithm)
+long long daysFromCivil(long long y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    long long era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = static_cast<unsigned>(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<long long>(doe) - 719468;
+}
+
+void civilFromDays(long long z, long long& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    long long era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = static_cast<unsigned>(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<long long>(yoe) + era * 400 + (m <= 2);
+}
+
+} // namespace
+
+std::string Utils::formatHttpDate(std::time_t time) {
+    // Computed by hand: std::gmtime is not thread-safe
+    long long seconds = static_cast<long long>(time);
+    long long days = seconds >= 0 ? seconds / 86400 : (seconds - 86399) / 86400;
+    long long secondsOfDay = seconds - days * 86400;
+    
+    long long year;
+    unsigned month, day;
+    civilFromDays(days, year, month, day);
+    unsigned weekday = static_cast<unsigned>((days % 7 + 11) % 7);
+    
+    int secondOfDay = static_cast<int>(secondsOfDay); // 0..86399
+    
+    // Room for any 64-bit year, so the output is never truncated
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%s, %02u %s %04lld %02d:%02d:%02d GMT",
+                  kWeekdays[weekday], day, kMonths[month - 1], year,
+                  secondOfDay / 3600, (secondOfDay / 60) % 60, secondOfDay % 60);
+    return buffer;
+}
+
+bool Utils::parseHttpDate(const std::string& date, std::time_t& time) {
+    char weekday[4] = {0};
+    char monthName[4] = {0};
+    int day, year, hour, minute, second;
+    if (std::sscanf(date.c_str(), "%3s, %d %3s %d %d:%d:%d", weekday, &day, monthName,
+                    &year, &hour, &minute, &second) != 7) {
+        return false;
+    }
+    
+    unsigned month = 0;
+    for (unsigned i = 0; i < 12; ++i) {
+        if (std::string(monthName) == kMonths[i]) {
+            month = i + 1;
+        }
+    }
+    if (month == 0 || day < 1 || day > 31 || hour < 0 || hour > 23 ||
+        minute < 0 || minute > 59 || second < 0 || second > 60) {
+        return false;
+    }
+    
+    long long days = daysFromCivil(year, month, static_cast<unsigned>(day));
+    time = static_cast<std::time_t>(days * 86400 + hour * 3600 + minute * 60 + second);
+    return true;
+}
+
 std::string Utils::getFileSize(const std::string& path) {
     try {
         std::filesystem::path filePath(path);
@@ -216,12 +280,15 @@ void Utils::initializeStatusTexts() {
         {200, "OK"},
         {201, "Created"},
         {204, "No Content"},
+        {206, "Partial Content"},
         {301, "Moved Permanently"},
         {302, "Found"},
+        {304, "Not Modified"},
         {400, "Bad Request"},
         {401, "Unauthorized"},
         {403, "Forbidden"},
         {404, "Not Found"},
+        {416, "Range Not Satisfiable"},
         {500, "Internal Server Error"},
         {501, "Not Implemented"},
         {502, "Bad Gateway"},